@@ -0,0 +1,279 @@
+#ifndef CHANNEL_H
+#define CHANNEL_H
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <optional>
+#include <future>
+#include <chrono>
+
+#include "mpmcqueue.h"
+
+/*
+н߶ͨˮߵĸ׶֮䴫
+example:
+Channel<Row> rows(1024);
+//
+rows.send(row);     //ȴ
+rows.close();       //ٷͣշȡʣݺrecvfalse
+//
+Row row;
+while (rows.recv(row)) { ... }
+//̳߳첽գȴڼ䲻ռụ̀߳handlerÿֻһҪվhandlerٵrecvAsync
+rows.recvAsync(pool, [&](std::optional<Row> row) { if (row) { ... } });
+
+ֱշֻж/Ҫȴʱż
+ȴȵǼټУշټûеȴм䶼seq_cstդ©
+*/
+
+//TҪĬϹƶֵ
+template<typename T>
+class Channel
+{
+public:
+	//handlerյstd::nulloptʾͨѹرղȡ
+	using AsyncHandler = std::function<void(std::optional<T>)>;
+
+	//ȡ2
+	explicit Channel(size_t capacity)
+		:que_(capacity > 0 ? capacity : 1)
+	{}
+
+	~Channel() = default;
+
+	//ʱfalsevalueᱻߣͨѹرҲfalse
+	template<typename U>
+	bool trySend(U&& value)
+	{
+		//state_λڷ͵߳close()֮ķͷֱʧ
+		bool isPushed = !(state_.fetch_add(SENDER_ONE) & CLOSED_BIT) && que_.tryPush(std::forward<U>(value));
+		if (state_.fetch_sub(SENDER_ONE) - SENDER_ONE == CLOSED_BIT)
+		{
+			//ͨѹرգһͷ뿪󲻻ݣнշ
+			wakeAll();
+		}
+		else if (isPushed)
+		{
+			wakeReceivers();
+		}
+		return isPushed;
+	}
+
+	//ʱȴͨѹرշfalse
+	template<typename U>
+	bool send(U&& value)
+	{
+		for (;;)
+		{
+			if (trySend(std::forward<U>(value)))
+			{
+				return true;
+			}
+			if (isClosed())
+			{
+				return false;
+			}
+
+			std::unique_lock<std::mutex> lock(mtx_);
+			sendWaiters_++;
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (que_.size() >= que_.capacity() && !isClosed())
+			{
+				notFull_.wait(lock);
+			}
+			sendWaiters_--;
+		}
+	}
+
+	//пʱfalse
+	bool tryRecv(T& value)
+	{
+		if (!que_.tryPop(value))
+		{
+			return false;
+		}
+		wakeSenders();
+		return true;
+	}
+
+	//пʱȴͨرղȡ󷵻false
+	bool recv(T& value)
+	{
+		for (;;)
+		{
+			if (tryRecv(value))
+			{
+				return true;
+			}
+			if (isDrained())
+			{
+				return false;
+			}
+
+			std::unique_lock<std::mutex> lock(mtx_);
+			recvWaiters_++;
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (que_.empty() && !isDrained())
+			{
+				notEmpty_.wait(lock);
+			}
+			recvWaiters_--;
+		}
+	}
+
+	//첽һԪأʱhandlerύִ̳߳У÷
+	//ύܾʱhandlerڵǰִ߳
+	template<typename Pool>
+	void recvAsync(Pool& pool, AsyncHandler handler)
+	{
+		AsyncReceiver receiver = [&pool, handler](std::optional<T>&& item) {
+			auto value = std::make_shared<std::optional<T>>(std::move(item));
+			if (!pool.trySubmit([handler, value]() {
+				handler(std::move(*value));
+			}))
+			{
+				handler(std::move(*value));
+			}
+		};
+
+		T value;
+		if (tryRecv(value))
+		{
+			receiver(std::move(value));
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(mtx_);
+			asyncReceivers_.emplace_back(std::move(receiver));
+			recvWaiters_++;
+		}
+		//Ǽ֮ݿѾˣһ
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		dispatchAsync();
+	}
+
+	//رͨٷͣѾڶеȻԽ
+	void close()
+	{
+		state_.fetch_or(CLOSED_BIT);
+		wakeAll();
+	}
+
+	bool isClosed() const
+	{
+		return (state_.load() & CLOSED_BIT) != 0;
+	}
+
+	//ʱֻһֵ
+	size_t size() const
+	{
+		return que_.size();
+	}
+
+	size_t capacity() const
+	{
+		return que_.capacity();
+	}
+
+	Channel(const Channel&) = delete;
+	Channel& operator=(const Channel&) = delete;
+
+private:
+	using AsyncReceiver = std::function<void(std::optional<T>&&)>;
+
+	static constexpr size_t CLOSED_BIT = 1;
+	static constexpr size_t SENDER_ONE = 2;
+
+	//ѹرաûڷ͵̲߳ҶΪգ֮󲻻
+	bool isDrained() const
+	{
+		return state_.load() == CLOSED_BIT && que_.empty();
+	}
+
+	void wakeReceivers()
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (recvWaiters_.load() == 0)
+		{
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(mtx_);
+			notEmpty_.notify_one();
+		}
+		dispatchAsync();
+	}
+
+	void wakeSenders()
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (sendWaiters_.load() == 0)
+		{
+			return;
+		}
+		std::lock_guard<std::mutex> lock(mtx_);
+		notFull_.notify_one();
+	}
+
+	void wakeAll()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mtx_);
+			notFull_.notify_all();
+			notEmpty_.notify_all();
+		}
+		dispatchAsync();
+	}
+
+	//ݽȴе첽շͨرղȡ֪ͨʣµĽշ
+	void dispatchAsync()
+	{
+		for (;;)
+		{
+			AsyncReceiver receiver;
+			std::optional<T> item;
+			{
+				std::lock_guard<std::mutex> lock(mtx_);
+				if (asyncReceivers_.empty())
+				{
+					return;
+				}
+				T value;
+				if (que_.tryPop(value))
+				{
+					item = std::move(value);
+				}
+				else if (!isDrained())
+				{
+					return;
+				}
+				receiver = std::move(asyncReceivers_.front());
+				asyncReceivers_.pop_front();
+				recvWaiters_--;
+			}
+			//ύύܾʱhandlerֱִ
+			if (item)
+			{
+				wakeSenders();
+			}
+			receiver(std::move(item));
+		}
+	}
+
+private:
+	MpmcQueue<T> que_;
+	std::atomic<size_t> state_{ 0 }; //CLOSED_BIT | ڷ͵߳ * SENDER_ONE
+
+	std::mutex mtx_; //ֻҪȴʱʹ
+	std::condition_variable notFull_;
+	std::condition_variable notEmpty_;
+	std::atomic_int sendWaiters_{ 0 }; //notFull_ϵķͷ
+	std::atomic_int recvWaiters_{ 0 }; //notEmpty_ϵĽշ첽շ
+	std::deque<AsyncReceiver> asyncReceivers_; //ȴݵ첽շmtx_
+};
+
+#endif
@@ -0,0 +1,171 @@
+#ifndef MPMCQUEUE_H
+#define MPMCQUEUE_H
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+const size_t CACHE_LINE_SIZE = 64;
+
+//н߶УVyukovĻζУ
+//ÿλһţߺ߸CASռλãλűʾòλǰǷд/ɶ
+template<typename T>
+class MpmcQueue
+{
+public:
+	//capacityȡ2ݣΪ0ʱҪʹǰinit
+	explicit MpmcQueue(size_t capacity = 0)
+	{
+		if (capacity > 0)
+		{
+			init(capacity);
+		}
+	}
+
+	~MpmcQueue()
+	{
+		clear();
+	}
+
+	//λֻû߳ʹöʱ
+	void init(size_t capacity)
+	{
+		clear();
+		size_t size = 2;
+		while (size < capacity)
+		{
+			size <<= 1;
+		}
+		cells_.reset(new Cell[size]);
+		mask_ = size - 1;
+		for (size_t i = 0; i < size; i++)
+		{
+			cells_[i].seq.store(i, std::memory_order_relaxed);
+		}
+		enqueuePos_.store(0, std::memory_order_relaxed);
+		dequeuePos_.store(0, std::memory_order_relaxed);
+	}
+
+	//ʱfalsevalueᱻ
+	template<typename U>
+	bool tryPush(U&& value)
+	{
+		size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			Cell& cell = cells_[pos & mask_];
+			size_t seq = cell.seq.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+			if (diff == 0)
+			{
+				if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					new (cell.data()) T(std::forward<U>(value));
+					cell.seq.store(pos + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0)
+			{
+				//λһֵݻûȡߣ
+				return false;
+			}
+			else
+			{
+				pos = enqueuePos_.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	//пʱfalse
+	bool tryPop(T& value)
+	{
+		size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			Cell& cell = cells_[pos & mask_];
+			size_t seq = cell.seq.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+			if (diff == 0)
+			{
+				if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					T* data = cell.data();
+					value = std::move(*data);
+					data->~T();
+					cell.seq.store(pos + mask_ + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0)
+			{
+				return false;
+			}
+			else
+			{
+				pos = dequeuePos_.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	//ʱֻһֵ
+	size_t size() const
+	{
+		size_t enq = enqueuePos_.load(std::memory_order_acquire);
+		size_t deq = dequeuePos_.load(std::memory_order_acquire);
+		return enq > deq ? enq - deq : 0;
+	}
+
+	bool empty() const
+	{
+		size_t pos = dequeuePos_.load(std::memory_order_acquire);
+		return cells_[pos & mask_].seq.load(std::memory_order_acquire) != pos + 1;
+	}
+
+	size_t capacity() const
+	{
+		return cells_ ? mask_ + 1 : 0;
+	}
+
+	MpmcQueue(const MpmcQueue&) = delete;
+	MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+private:
+	struct Cell
+	{
+		std::atomic<size_t> seq;
+		alignas(T) unsigned char storage[sizeof(T)];
+
+		T* data()
+		{
+			return reinterpret_cast<T*>(storage);
+		}
+	};
+
+	//ʣԪ
+	void clear()
+	{
+		if (!cells_)
+		{
+			return;
+		}
+		size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+		size_t end = enqueuePos_.load(std::memory_order_relaxed);
+		for (; pos != end; pos++)
+		{
+			cells_[pos & mask_].data()->~T();
+		}
+		cells_.reset();
+	}
+
+private:
+	std::unique_ptr<Cell[]> cells_;
+	size_t mask_ = 0;
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> enqueuePos_{ 0 }; //ߺߵλ÷ڲͬĻУα
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> dequeuePos_{ 0 };
+};
+
+#endif
@@ -0,0 +1,161 @@
+#ifndef THREADBUDGET_H
+#define THREADBUDGET_H
+
+#include <iostream>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <algorithm>
+
+/*
+̳߳ع߳Ԥ㣬̳߳ͬʱִĹ߳
+example:
+ThreadBudget budget;  //ĬΪCPU
+ThreadPool rpc, compaction;
+rpc.setThreadBudget(budget, 4);        //rpcٿͬʱִ4
+compaction.setThreadBudget(budget, 1);
+rpc.start();
+compaction.start();
+
+ִ߳һǰȡһִ黹ᳬޣ
+̳߳ؿʱԽǵı̳߳ڱڵȴʱ̳߳زٽã
+黹ȸȴ÷ִ굱ǰ
+̳߳صıޣעֻ̳߳ܵõûռõ
+budgetҪע̳߳ػþãȴͬһԤµ
+*/
+class ThreadBudget
+{
+public:
+	//һע̳߳
+	struct Member
+	{
+		int guaranteed = 0; //
+		std::atomic_int running{ 0 }; //ִĹ߳
+	};
+
+	explicit ThreadBudget(int maxRunnable = std::thread::hardware_concurrency())
+		:maxRunnable_(std::max(maxRunnable, 1))
+	{}
+
+	~ThreadBudget() = default;
+
+	//̳߳עᣬлû̳߳رռõĲ֣򱣵޷
+	Member* join(int guaranteed)
+	{
+		std::lock_guard<std::mutex> lock(mtx_);
+		int reserved = 0;
+		for (auto& member : members_)
+		{
+			reserved += member->guaranteed;
+		}
+		int granted = std::min(std::max(guaranteed, 0), maxRunnable_ - reserved);
+		if (granted < guaranteed)
+		{
+			std::cerr << "thread budget: guaranteed " << guaranteed << " reduced to " << granted << std::endl;
+		}
+		members_.emplace_back(std::make_unique<Member>());
+		members_.back()->guaranteed = granted;
+		return members_.back().get();
+	}
+
+	void leave(Member* member)
+	{
+		std::lock_guard<std::mutex> lock(mtx_);
+		members_.erase(std::remove_if(members_.begin(), members_.end(),
+			[member](const std::unique_ptr<Member>& m) { return m.get() == member; }), members_.end());
+	}
+
+	//ȡһûʱȴ
+	void acquire(Member* member)
+	{
+		if (tryAcquire(member))
+		{
+			return;
+		}
+		std::unique_lock<std::mutex> lock(mtx_);
+		waiters_++;
+		//ڵȴֹ̳߳ؼ
+		bool isStarved = member->running < member->guaranteed;
+		if (isStarved)
+		{
+			starved_++;
+		}
+		//releaseеդԣ֤Ҫô￴黹Ҫôreleasewaiters_
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		while (!tryAcquire(member))
+		{
+			released_.wait(lock);
+		}
+		if (isStarved)
+		{
+			starved_--;
+		}
+		waiters_--;
+	}
+
+	void release(Member* member)
+	{
+		member->running--;
+		running_--;
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (waiters_.load(std::memory_order_relaxed) > 0)
+		{
+			std::lock_guard<std::mutex> lock(mtx_);
+			released_.notify_all();
+		}
+	}
+
+	//п̳߳ǰж
+	bool hasCapacity() const
+	{
+		return running_ < maxRunnable_;
+	}
+
+	int getMaxRunnable() const
+	{
+		return maxRunnable_;
+	}
+
+	//ִ̳߳Ĺ߳
+	int getRunning() const
+	{
+		return running_;
+	}
+
+	ThreadBudget(const ThreadBudget&) = delete;
+	ThreadBudget& operator=(const ThreadBudget&) = delete;
+
+private:
+	bool tryAcquire(Member* member)
+	{
+		//ʱǽã̳߳ڵȴʱܽ
+		if (member->running >= member->guaranteed && starved_ > 0)
+		{
+			return false;
+		}
+		int running = running_.load();
+		while (running < maxRunnable_)
+		{
+			if (running_.compare_exchange_weak(running, running + 1))
+			{
+				member->running++;
+				return true;
+			}
+		}
+		return false;
+	}
+
+private:
+	const int maxRunnable_; //ͬʱִĹ߳
+	std::atomic_int running_{ 0 };
+	std::atomic_int waiters_{ 0 }; //ȴĹ߳
+	std::atomic_int starved_{ 0 }; //ڱڵȴĹ߳
+	std::mutex mtx_; //members_ȴʱʹ
+	std::condition_variable released_;
+	std::vector<std::unique_ptr<Member>> members_;
+};
+
+#endif
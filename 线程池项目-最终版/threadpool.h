@@ -4,6 +4,7 @@
 #include <iostream>
 #include <vector>
 #include <queue>
+#include <deque>
 #include <memory>
 #include <atomic>
 #include <mutex>
@@ -12,10 +13,50 @@
 #include <unordered_map>
 #include <thread>
 #include <future>
+#include <string>
+#include <typeindex>
+#include <stdexcept>
+#include <type_traits>
+#include <map>
+#include <algorithm>
+#include <cstddef>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+#include "mpmcqueue.h"
+#include "threadpool_trace.h"
+#include "threadbudget.h"
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <sched.h>
+#include <cerrno>
+#include <fstream>
+#endif
 
 const int TASK_MAX_THRESHHOLD = INT32_MAX;
+const int SUBMIT_TIMEOUT_MS = 1000;//ʱύôãλ
 const int THREAD_MAX_THRESHHOLD = 10;
 const int THREAD_MAX_IDLE_TIME = 10;//λ
+const int REACTOR_MAX_EVENTS = 64;//reactorepoll_waitȡ¼
+const int CODEL_TARGET_MS = 5;//ŶʱĿֵλ
+const int CODEL_INTERVAL_MS = 100;//ŶʱĿֵôΪأλ
+const int SHARED_TASK_SHARDS = 16;//submitShared;Ƭ
+const size_t SHARED_SWEEP_SIZE = 1024;//ƬԪسʱڵĻ
+const size_t LOCKFREE_QUEUE_MAX_SIZE = 1 << 16;//еҪԤȷ
+const int SPIN_WAIT_ROUNDS = 256;//ȴʱpauseôΣóCPU
+const size_t INLINE_TASK_SIZE = 64;//InlineTaskڲСŵµöѷ
+const size_t TASK_BATCH_MAX_SIZE = 32;//߳һμȡ
+const int64_t TASK_BATCH_SHORT_TASK_NS = 50000;//ƽʱֵȡλ
+const int LOCAL_STEAL_DELAY_US = 200;//õָ̻߳򻺴Ŷӳôã΢룩߳͵
+const int HEDGE_BUDGET_PERCENT = 10;//ԳִжύԳٷֱ
+const int HEDGE_PERCENTILE = 95;//ӦԳӳȡʷִʱٷλ
+const size_t HEDGE_HISTORY_SIZE = 256;//ÿôεִʱ
+const size_t HEDGE_MIN_SAMPLES = 16;//˲ʹӦӳ٣֮ÿܹô¼һ
 
 //ֵ̳֧߳ģʽ
 enum class PoolMode
@@ -24,6 +65,362 @@ enum class PoolMode
 	MODE_CACHED, //߳ɶ̬
 };
 
+//⻧idsubmitTask(tenantId, ...)ύ⻧Ȩعƽ
+using TenantId = int;
+const TenantId NO_TENANT = -1;//κ⻧
+
+//ķ÷ʽsubmitTask(TaskPlacement, ...)ʹ
+enum class PlacementKind
+{
+	PLACE_ANY,            //⹤̣߳ͨsubmitTaskһ
+	PLACE_CURRENT_WORKER, //ǰ̣߳ȳʺʹøղݵĺ
+	PLACE_WORKER,         //ָ±Ḷ́߳ύ˳Ƚȳ
+	PLACE_SAME_GROUP,     //ύ߳ͬһL3򣨶ȡʱNUMAڵ㣩Ḷ́߳Ƚȳ
+};
+
+struct TaskPlacement
+{
+	PlacementKind kind = PlacementKind::PLACE_ANY;
+	int worker = -1; //PLACE_WORKERʱĹ߳±꣬getWorkerIndex()
+
+	static TaskPlacement currentWorker()
+	{
+		return TaskPlacement{ PlacementKind::PLACE_CURRENT_WORKER, -1 };
+	}
+	static TaskPlacement onWorker(int worker)
+	{
+		return TaskPlacement{ PlacementKind::PLACE_WORKER, worker };
+	}
+	static TaskPlacement sameGroup()
+	{
+		return TaskPlacement{ PlacementKind::PLACE_SAME_GROUP, -1 };
+	}
+};
+
+//CPUڵĻ飬ȰL3飬ȡʱNUMAڵ㣬ȡʱֻһ
+//̲߳ˣÿȡʱǰڵCPUȷ
+class CpuTopology
+{
+public:
+	static const CpuTopology& instance()
+	{
+		static CpuTopology topology;
+		return topology;
+	}
+
+	int groupCount() const
+	{
+		return groupCount_;
+	}
+
+	//ǰ߳CPUķ
+	int currentGroup() const
+	{
+#ifdef __linux__
+		int cpu = ::sched_getcpu();
+		if (cpu >= 0 && cpu < (int)cpuGroup_.size())
+		{
+			return cpuGroup_[cpu];
+		}
+#endif
+		return 0;
+	}
+
+private:
+	CpuTopology()
+	{
+#ifdef __linux__
+		int cpus = (int)::sysconf(_SC_NPROCESSORS_CONF);
+		if (!loadGroups(cpus, true) && !loadGroups(cpus, false))
+		{
+			cpuGroup_.clear();
+			groupCount_ = 1;
+		}
+#endif
+	}
+
+#ifdef __linux__
+	//byCacheΪtrueʱL3shared_cpu_list飬CPUNUMAڵ
+	bool loadGroups(int cpus, bool byCache)
+	{
+		std::map<std::string, int> groups;
+		cpuGroup_.assign(cpus > 0 ? cpus : 0, 0);
+		for (int cpu = 0; cpu < cpus; cpu++)
+		{
+			std::string key = byCache ? readL3Key(cpu) : readNodeKey(cpu);
+			if (key.empty())
+			{
+				return false;
+			}
+			auto it = groups.emplace(key, (int)groups.size()).first;
+			cpuGroup_[cpu] = it->second;
+		}
+		groupCount_ = std::max((int)groups.size(), 1);
+		return !groups.empty();
+	}
+
+	static std::string readL3Key(int cpu)
+	{
+		std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cache/index";
+		for (int index = 0; index < 8; index++)
+		{
+			std::ifstream level(dir + std::to_string(index) + "/level");
+			int value = 0;
+			if (!(level >> value))
+			{
+				break;
+			}
+			std::ifstream shared(dir + std::to_string(index) + "/shared_cpu_list");
+			std::string list;
+			if (value == 3 && (shared >> list))
+			{
+				return list;
+			}
+		}
+		return "";
+	}
+
+	static std::string readNodeKey(int cpu)
+	{
+		for (int node = 0; node < 1024; node++)
+		{
+			std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/node" + std::to_string(node);
+			if (::access(path.c_str(), F_OK) == 0)
+			{
+				return std::to_string(node);
+			}
+		}
+		return "";
+	}
+#endif
+
+private:
+	std::vector<int> cpuGroup_; //CPU -> 
+	int groupCount_ = 1;
+};
+
+//ǰִ߳еĶԳɱ־
+inline const std::atomic_bool*& currentCancelFlag()
+{
+	static thread_local const std::atomic_bool* flag = nullptr;
+	return flag;
+}
+
+//submitHedgedύãһִѾɡѾʱtrueǰݿǰ
+//ڶԳʱǷfalse
+inline bool isTaskCancelRequested()
+{
+	const std::atomic_bool* flag = currentCancelFlag();
+	return flag != nullptr && flag->load(std::memory_order_relaxed);
+}
+
+//̳߳ص׼Ʒʽ
+enum class AdmissionMode
+{
+	ADMIT_QUEUE_SIZE, //ֻг
+	ADMIT_CODEL,      //ⰴŶʱжϹأʱܾ
+};
+
+/*
+BasicThreadPoolıڲԣûѡеʵڱȥFixedGrowth²ά߳ģʽж
+QueuePolicy  LockedQueue +std::queue / LockFreeQueue н
+WaitPolicy   CondVarWait ߳ / SpinWait ߳ȴ
+GrowthPolicy RuntimeGrowth ʱsetMode / FixedGrowth ̶߳ / CachedGrowth ߳
+TaskStorage  std::function<void()> / InlineTask ֻƶСöѷ
+ThreadBudgetִй켣¼ֹʱ䡢CoDel׼롢⻧áȥغͶԳ岻ǱڲԣʱŴ򿪣
+ÿ̳߳ضǵĳԱûʹʱ·ϸʣһβֵָжϣ
+жзŶʱȡҪһsched_getcpu
+*/
+struct LockedQueue
+{
+	static constexpr bool isLockFree = false;
+	template<typename T>
+	using Queue = std::queue<T>;
+};
+
+//CoDel׼벻ЧĽֹʱȻЧ
+struct LockFreeQueue
+{
+	static constexpr bool isLockFree = true;
+	template<typename T>
+	using Queue = MpmcQueue<T>;
+};
+
+struct CondVarWait
+{
+	static constexpr bool isSpin = false;
+};
+
+//̻߳һֱռCPUʺ߳ӳеĳ
+struct SpinWait
+{
+	static constexpr bool isSpin = true;
+	static void pause()
+	{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+		_mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+		__builtin_ia32_pause();
+#else
+		std::this_thread::yield();
+#endif
+	}
+};
+
+struct RuntimeGrowth
+{
+	static constexpr bool isRuntime = true;
+	static constexpr PoolMode mode = PoolMode::MODE_FIXED; //ĬģʽsetMode޸
+};
+
+struct FixedGrowth
+{
+	static constexpr bool isRuntime = false;
+	static constexpr PoolMode mode = PoolMode::MODE_FIXED;
+};
+
+struct CachedGrowth
+{
+	static constexpr bool isRuntime = false;
+	static constexpr PoolMode mode = PoolMode::MODE_CACHED;
+};
+
+//ֻƶֱͣӴpackaged_taskʡstd::functionҪshared_ptrװ
+//INLINE_TASK_SIZEĿɵöڲŵ
+class InlineTask
+{
+public:
+	InlineTask() = default;
+	InlineTask(std::nullptr_t) {}
+
+	template<typename F, typename = std::enable_if_t<!std::is_same<std::decay_t<F>, InlineTask>::value>>
+	InlineTask(F&& func)
+	{
+		using Fn = std::decay_t<F>;
+		if constexpr (Ops<Fn>::isSmall)
+		{
+			new (buf_) Fn(std::forward<F>(func));
+		}
+		else
+		{
+			*reinterpret_cast<Fn**>(buf_) = new Fn(std::forward<F>(func));
+		}
+		ops_ = &Ops<Fn>::table;
+	}
+
+	InlineTask(InlineTask&& other) noexcept
+	{
+		moveFrom(other);
+	}
+
+	InlineTask& operator=(InlineTask&& other) noexcept
+	{
+		if (this != &other)
+		{
+			reset();
+			moveFrom(other);
+		}
+		return *this;
+	}
+
+	~InlineTask()
+	{
+		reset();
+	}
+
+	void operator()()
+	{
+		ops_->invoke(buf_);
+	}
+
+	explicit operator bool() const
+	{
+		return ops_ != nullptr;
+	}
+
+	InlineTask(const InlineTask&) = delete;
+	InlineTask& operator=(const InlineTask&) = delete;
+
+private:
+	struct OpsTable
+	{
+		void (*invoke)(void*);
+		void (*move)(void* dst, void* src);
+		void (*destroy)(void*);
+	};
+
+	template<typename Fn>
+	struct Ops
+	{
+		static constexpr bool isSmall = sizeof(Fn) <= INLINE_TASK_SIZE
+			&& alignof(Fn) <= alignof(std::max_align_t)
+			&& std::is_nothrow_move_constructible<Fn>::value;
+
+		static Fn* get(void* buf)
+		{
+			if constexpr (isSmall)
+			{
+				return static_cast<Fn*>(buf);
+			}
+			else
+			{
+				return *static_cast<Fn**>(buf);
+			}
+		}
+		static void invoke(void* buf)
+		{
+			(*get(buf))();
+		}
+		static void move(void* dst, void* src)
+		{
+			if constexpr (isSmall)
+			{
+				new (dst) Fn(std::move(*get(src)));
+				get(src)->~Fn();
+			}
+			else
+			{
+				*static_cast<Fn**>(dst) = *static_cast<Fn**>(src);
+			}
+		}
+		static void destroy(void* buf)
+		{
+			if constexpr (isSmall)
+			{
+				get(buf)->~Fn();
+			}
+			else
+			{
+				delete get(buf);
+			}
+		}
+		static constexpr OpsTable table = { &invoke, &move, &destroy };
+	};
+
+	void moveFrom(InlineTask& other)
+	{
+		ops_ = other.ops_;
+		if (ops_ != nullptr)
+		{
+			ops_->move(buf_, other.buf_);
+			other.ops_ = nullptr;
+		}
+	}
+
+	void reset()
+	{
+		if (ops_ != nullptr)
+		{
+			ops_->destroy(buf_);
+			ops_ = nullptr;
+		}
+	}
+
+private:
+	alignas(std::max_align_t) unsigned char buf_[INLINE_TASK_SIZE];
+	const OpsTable* ops_ = nullptr;
+};
+
 //߳
 class Thread
 {
@@ -60,24 +457,38 @@ private:
 int Thread::generatedId_ = 0;
 
 //̳߳
-class ThreadPool
+template<typename QueuePolicy = LockedQueue,
+	typename WaitPolicy = CondVarWait,
+	typename GrowthPolicy = RuntimeGrowth,
+	typename TaskStorage = std::function<void()>>
+class BasicThreadPool
 {
 public:
 	//̳߳ع
-	ThreadPool()
+	BasicThreadPool()
 		:initThreadSize_(0)
+		, idleThreadSize_(0)
+		, curThreadSize_(0)
+		, threadSizeThreshHold_(THREAD_MAX_THRESHHOLD)
 		, taskSize_(0)
 		, taskQueMaxThreshHold_(TASK_MAX_THRESHHOLD)
-		, poolMode_(PoolMode::MODE_FIXED)
+		, poolMode_(GrowthPolicy::mode)
 		, isPoolRunning_(false)
-		, idleThreadSize_(0)
-		, threadSizeThreshHold_(THREAD_MAX_THRESHHOLD)
-		, curThreadSize_(0)
+		, admissionMode_(AdmissionMode::ADMIT_QUEUE_SIZE)
+		, codelTarget_(std::chrono::milliseconds(CODEL_TARGET_MS))
+		, codelInterval_(std::chrono::milliseconds(CODEL_INTERVAL_MS))
+		, isOverloaded_(false)
 	{}
 
 	//̳߳
-	~ThreadPool()
+	~BasicThreadPool()
 	{
+#ifdef __linux__
+		//ֹͣreactor֤о¼Ͷݽ
+		stopReactor();
+#endif
+		//Գ嶨ʱύҲҪֹͣ
+		stopTimer();
 		isPoolRunning_ = false;
 
 		//notEmpty_.notify_all();//ΪûTaskִУnotEmpty_.wait_forϵ̣߳ -ȴ-
@@ -86,14 +497,24 @@ public:
 		std::unique_lock<std::mutex> lock(taskQueMtx_);
 
 		notEmpty_.notify_all();
+		wakeWorkers();
 
 		exitCond_.wait(lock, [&]()->bool { return threads_.size() == 0; });
+
+		if (budget_ != nullptr)
+		{
+			budget_->leave(budgetMember_);
+		}
+
+		//̶߳˳ˣʣĹ켣д
+		stopRecording();
 	}
 
 	//̵߳Ĺģʽ
 	void setMode(PoolMode mode)
 	{
-		if (checkRunningState())
+		//ȷģʽ̳߳ز޸
+		if (checkRunningState() || !GrowthPolicy::isRuntime)
 		{
 			return;
 		}
@@ -107,13 +528,26 @@ public:
 		{
 			return;
 		}
-		if (poolMode_ == PoolMode::MODE_CACHED)
+		if (isCachedMode())
 		{
 			threadSizeThreshHold_ = threshhold;
 		}
 	}
 
-	//taskֵ
+	//̳߳ع߳Ԥ㣬guaranteedΪ̳߳ر׿ͬʱִĹ߳
+	//Ԥлû̳߳رռõʱֻܵõʣµĲ
+	//ͬʱִĹ߳ԤƣcachedģʽҲֻԤпʱŴ߳
+	void setThreadBudget(ThreadBudget& budget, int guaranteed)
+	{
+		if (checkRunningState() || budget_ != nullptr)
+		{
+			return;
+		}
+		budget_ = &budget;
+		budgetMember_ = budget.join(guaranteed);
+	}
+
+	//taskֵ⻧в룬ÿ⻧setTenantmaxQueued
 	void setTaskQueMaxThreshHold(int threshhold)
 	{
 		if (checkRunningState())
@@ -123,179 +557,1901 @@ public:
 		taskQueMaxThreshHold_ = threshhold;
 	}
 
+	//׼Ʒʽ
+	void setAdmissionMode(AdmissionMode mode)
+	{
+		if (checkRunningState())
+		{
+			return;
+		}
+		admissionMode_ = mode;
+	}
+
+	//CoDel׼ŶʱĿֵжصʱ䴰
+	//ŶʱintervalһֱtargetͿʼֱܾŶʱ併
+	void setCodelParams(std::chrono::milliseconds target, std::chrono::milliseconds interval)
+	{
+		if (checkRunningState())
+		{
+			return;
+		}
+		codelTarget_ = target;
+		codelInterval_ = interval;
+	}
+
+	//submitSharedɽĻʱ䣬0ʾɺ󲻻
+	void setSharedResultTTL(std::chrono::milliseconds ttl)
+	{
+		sharedResultTTL_ = ttl;
+	}
+
+	//öԳִжύޣռԳİٷֱȣ0ʾٶԳ
+	void setHedgeBudget(int percent)
+	{
+		hedgeBudgetPercent_ = std::max(percent, 0);
+	}
+
+	//⻧Ȩءͬʱִе޺ŶӵޣmaxInFlightΪ0ʾƣ
+	//maxQueuedΪ0ʾֵһ⻧ĶʱֻӰԼύ񣬲ᵲס⻧
+	//⻧֮䰴Ȩȡdeficit round robinûù⻧ȨΪ1
+	void setTenant(TenantId tenantId, int weight, int maxInFlight = 0, int maxQueued = 0)
+	{
+		static_assert(!QueuePolicy::isLockFree, "tenant scheduling needs LockedQueue");
+		std::lock_guard<std::mutex> lock(taskQueMtx_);
+		TenantState* tenant = getTenant(tenantId);
+		tenant->weight = std::max(weight, 1);
+		tenant->maxInFlight = std::max(maxInFlight, 0);
+		tenant->maxQueued = std::max(maxQueued, 0);
+		//޵Ժ󣬱⻧ܿԼִ
+		resumeTenantIfPossible(tenant);
+	}
+
 	//̳߳ύ
 	//ʹÿɱģ̣submitTask ԽĲ
 	template<typename Func, typename... Args>
 	auto submitTask(Func&& func, Args&&... args) -> std::future<decltype(func(args...))>
+	{
+		return submitTaskUntil(Clock::time_point::max(), std::forward<Func>(func), std::forward<Args>(args)...);
+	}
+
+	//ύֹʱ񣬳ʱѾdeadlineֱӶִ
+	//future.get()׳broken_promise쳣
+	template<typename Func, typename... Args>
+	auto submitTaskUntil(std::chrono::steady_clock::time_point deadline, Func&& func, Args&&... args)
+		-> std::future<decltype(func(args...))>
 	{
 		// ŵ
 		using RType = decltype(func(args...));
-		auto task = std::make_shared<std::packaged_task<RType()>>(
-			std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
-		std::future<RType> result = task->get_future();
-
-		//ȡ
-		std::unique_lock<std::mutex> lock(taskQueMtx_);
-
-		//߳ͨţȴп  notFull_
-		//ûύ1s,жύʧܣ
-		if (!notFull_.wait_for(lock, std::chrono::seconds(1),
-			[&]()->bool {return taskQue_.size() < (size_t)taskQueMaxThreshHold_; }))
-		{
-			//ʾnotFull_ȴ1sȻû
-			std::cerr << "task queue is full, submit task faill." << std::endl;
-			auto task = std::make_shared<std::packaged_task<RType()>>(
-				[]()->RType { return RType(); });
-			(*task)();
-			return task->get_future();
-		}
-
-		//п࣬ŵ
-		taskQue_.emplace([task](){ (*task)(); });
-		taskSize_++;
-
-		//Ϊп϶ˣnotEmpty_Ͻ֪ͨ
-		notEmpty_.notify_all();
+		std::packaged_task<RType()> task(std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
+		std::future<RType> result = task.get_future();
 
-		//ҪͿ̵߳жǷҪµ̳߳
-		if (poolMode_ == PoolMode::MODE_CACHED
-			&& taskSize_ > idleThreadSize_
-			&& curThreadSize_ < threadSizeThreshHold_)
+		QueuedTask entry{ wrapTask(std::move(task)), enqueueTime(), deadline };
+		entry.taskClass = typeid(Func).name();
+		if (!pushTask(std::move(entry), NO_TENANT))
 		{
-			std::cout << ">>>>>create new thread...." << std::endl;
-			//̶߳
-			auto ptr = std::make_unique<Thread>(std::bind(&ThreadPool::threadFunc, this, std::placeholders::_1));
-			int threadId = ptr->getId();
-			threads_.emplace(threadId, std::move(ptr));
-			threads_[threadId]->start();//߳
-
-			//޸̸߳ر
-			curThreadSize_++; //ǰ߳
-			idleThreadSize_++;//߳
+			//߹أύʧ
+			return rejectedFuture<RType>();
 		}
 
 		//Result
 		//return task->getResult();
 		return result;
-
-
 	}
 
-	//̳߳
-	void start(int initThreadSize = std::thread::hardware_concurrency())
+	//ύ߹ʱȴֱӷfalseܾ񲻻ִУ÷Լִ
+	//futureҪԼȥ׳쳣
+	template<typename Func, typename... Args>
+	bool trySubmit(Func&& func, Args&&... args)
 	{
-		//̳߳״̬
-		isPoolRunning_ = true;
+		std::packaged_task<void()> task(std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
+		QueuedTask entry{ wrapTask(std::move(task)), enqueueTime(), Clock::time_point::max() };
+		entry.taskClass = typeid(Func).name();
+		return pushTask(std::move(entry), NO_TENANT, TaskPlacement(), std::chrono::milliseconds(0));
+	}
 
-		//¼ʼ̸߳
-		initThreadSize_ = initThreadSize;
-		//¼ǰ̸߳
-		curThreadSize_ = initThreadSize;
+	//⻧ύŵ⻧ԼĶ⻧Ȩعƽ
+	template<typename Func, typename... Args>
+	auto submitTask(TenantId tenantId, Func&& func, Args&&... args) -> std::future<decltype(func(args...))>
+	{
+		static_assert(!QueuePolicy::isLockFree, "tenant scheduling needs LockedQueue");
+		using RType = decltype(func(args...));
+		std::packaged_task<RType()> task(std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
+		std::future<RType> result = task.get_future();
 
-		//д̶߳
-		for (int i = 0; i < initThreadSize_; i++)
+		QueuedTask entry{ wrapTask(std::move(task)), Clock::now(), Clock::time_point::max() };
+		entry.taskClass = typeid(Func).name();
+		if (!pushTask(std::move(entry), tenantId))
 		{
-			//thread̶߳ʱ򣬰̺߳thread̶߳
-			auto ptr = std::make_unique<Thread>(std::bind(&ThreadPool::threadFunc, this, std::placeholders::_1));
-			int threadId = ptr->getId();
-			threads_.emplace(threadId, std::move(ptr));
+			return rejectedFuture<RType>();
 		}
+		return result;
+	}
 
-		//߳
-		for (int i = 0; i < initThreadSize_; i++)
+	//ָķ÷ʽύʹͬһݵĺͬһ̻߳ͬһִ
+	//ָĹ߳̿ʱֻæŶӳLOCAL_STEAL_DELAY_USʱ̲߳Ż͵ȥִ
+	//õ񲻻ᱻȡߣָĹ̲߳ʱPLACE_ANY
+	template<typename Func, typename... Args>
+	auto submitTask(TaskPlacement placement, Func&& func, Args&&... args) -> std::future<decltype(func(args...))>
+	{
+		static_assert(!QueuePolicy::isLockFree, "task placement needs LockedQueue");
+		using RType = decltype(func(args...));
+		std::packaged_task<RType()> task(std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
+		std::future<RType> result = task.get_future();
+
+		//̰߳ʱжܲ͵ߣǼ¼
+		QueuedTask entry{ wrapTask(std::move(task)), Clock::now(), Clock::time_point::max() };
+		entry.taskClass = typeid(Func).name();
+		if (!pushTask(std::move(entry), NO_TENANT, placement))
 		{
-			threads_[i]->start();
-			idleThreadSize_++;//¼߳
+			return rejectedFuture<RType>();
 		}
+		return result;
+	}
+
+	//ύȥصͬkeyŶӻִʱظύ
+	//ֱӷͬһĽ˽ʱĻɺĽttlҲֱӸ
+	//ͬһkeyӦͬһֵַ
+	//߹ύʧʱεúѾͬһ;ĵöõֵ͵Ĭֵ
+	template<typename Func, typename... Args>
+	auto submitShared(const std::string& key, Func&& func, Args&&... args)
+		-> std::shared_future<decltype(func(args...))>
+	{
+		using RType = decltype(func(args...));
+		SharedShard& shard = sharedShards_[std::hash<std::string>()(key) % SHARED_TASK_SHARDS];
+		//isRejectedΪtrueʱִֻеȴһĬֵ
+		std::shared_ptr<std::packaged_task<RType(bool)>> task;
+		std::shared_ptr<std::shared_future<RType>> result;
+		{
+			std::lock_guard<std::mutex> lock(shard.mtx);
+			auto now = Clock::now();
+			auto it = shard.entries.find(key);
+			if (it != shard.entries.end() && it->second.expireAt > now)
+			{
+				if (it->second.type != std::type_index(typeid(RType)))
+				{
+					throw std::logic_error("submitShared: key is used with another result type");
+				}
+				return *std::static_pointer_cast<std::shared_future<RType>>(it->second.result);
+			}
+
+			task = std::make_shared<std::packaged_task<RType(bool)>>(
+				[bound = std::bind(std::forward<Func>(func), std::forward<Args>(args)...)](bool isRejected) mutable->RType {
+					if (isRejected)
+					{
+						return RType();
+					}
+					return bound();
+				});
+			result = std::make_shared<std::shared_future<RType>>(task->get_future().share());
+			if (shard.entries.size() >= shard.sweepSize)
+			{
+				sweepShared(shard, now);
+			}
+			shard.entries.insert_or_assign(key, SharedEntry{ result, std::type_index(typeid(RType)), Clock::time_point::max() });
+		}
+
+		//ִԺ;
+		if (!trySubmit([this, &shard, key, task, result]() {
+			(*task)(false);
+			finishShared(shard, key, result, isReady(*result));
+		}))
+		{
+			//ύʧܣsubmitTaskһһĬֵͨͬһ״̬
+			//Ѿõ;ĵ÷ҲõĬֵbroken_promise
+			(*task)(true);
+			finishShared(shard, key, result, false);
+		}
+		return *result;
+	}
+
+	//ԳִУݵȵġβӳе
+	//һִпʼ󳬹afterûɣ㹻ʷʱȡafterʷִʱHEDGE_PERCENTILEλĽСֵ
+	//ύһݵ̣߳ɵĽ쳣ãһͨisTaskCancelRequested()֪ǰ
+	//ύsetHedgeBudgetƣѾѹʱҲٶԳ壬Ŵ
+	template<typename Func, typename... Args>
+	auto submitHedged(std::chrono::nanoseconds after, Func&& func, Args&&... args) -> std::future<decltype(func(args...))>
+	{
+		using RType = decltype(func(args...));
+		auto bound = std::bind(std::forward<Func>(func), std::forward<Args>(args)...);
+		auto state = std::make_shared<HedgeState<RType, decltype(bound)>>(std::move(bound), typeid(Func).name());
+		std::future<RType> result = state->promise.get_future();
+
+		hedgedCalls_++;
+		if (!submitAttempt(state))
+		{
+			//submitTaskһһĬֵ
+			return rejectedFuture<RType>();
+		}
+		addTimer(Clock::now() + hedgeDelay(state->taskClass, after), [this, state]() {
+			maybeHedge(state);
+		});
+		return result;
+	}
+
+	//ʼ¼켣pathļtools/threadpool_replay.cpp߻ط
+	//ÿ¼ύʱ䡢Ŷʱ䡢ִʱࣨύĿɵöͣ
+	//Ѿڼ¼ʱȽһμ¼ļʧܷfalse
+	bool startRecording(const std::string& path)
+	{
+		auto recorder = std::make_unique<TraceRecorder>();
+		if (!recorder->open(path))
+		{
+			return false;
+		}
+		std::lock_guard<std::mutex> lock(recorderMtx_);
+		TraceRecorder* old = recorder_.exchange(recorder.get());
+		if (old != nullptr)
+		{
+			old->close();
+		}
+		recorders_.emplace_back(std::move(recorder));
+		return true;
+	}
+
+	//¼ִеִ꣬ѹ̻߳еļ¼д겢رļ
+	//ǰѾɵļ
+	void stopRecording()
+	{
+		std::lock_guard<std::mutex> lock(recorderMtx_);
+		TraceRecorder* old = recorder_.exchange(nullptr);
+		if (old != nullptr)
+		{
+			old->close();
+		}
+	}
+
+	//̳߳
+	void start(int initThreadSize = std::thread::hardware_concurrency())
+	{
+		//̳߳״̬
+		isPoolRunning_ = true;
+
+		//¼ʼ̸߳
+		initThreadSize_ = initThreadSize;
+		//¼ǰ̸߳
+		curThreadSize_ = initThreadSize;
+
+		//ҪԤȷλ
+		if constexpr (QueuePolicy::isLockFree)
+		{
+			taskQue_.init(std::min((size_t)taskQueMaxThreshHold_, LOCKFREE_QUEUE_MAX_SIZE));
+		}
+		else
+		{
+			groupQues_.resize(CpuTopology::instance().groupCount());
+		}
+
+		//д̶߳
+		for (int i = 0; i < initThreadSize_; i++)
+		{
+			//thread̶߳ʱ򣬰̺߳thread̶߳
+			auto ptr = std::make_unique<Thread>(std::bind(&BasicThreadPool::threadFunc, this, std::placeholders::_1));
+			int threadId = ptr->getId();
+			threads_.emplace(threadId, std::move(ptr));
+		}
+
+		//̣߳߳idȫֵģܰ±ȡ
+		for (auto& entry : threads_)
+		{
+			entry.second->start();
+			if (tracksIdleThreads())
+			{
+				idleThreadSize_++;//¼߳
+			}
+		}
+	}
+
+	//ȡǰ߳
+	int getThreadSize() const
+	{
+		return curThreadSize_;
+	}
+
+	//ǰ̳߳߳еĹ߳±꣬0ʼǱ̳߳صĹ߳ʱ-1
+	//cachedģʽ»յ߳±ᱻ̸߳
+	int getWorkerIndex() const
+	{
+		const CurrentWorker& current = currentWorker();
+		return current.pool == this ? current.index : -1;
+	}
+
+	//⻧ͳϢ
+	struct TenantStats
+	{
+		size_t queueSize;   //Ŷе
+		int inFlight;       //ִеֻ˲ʱͳ
+		uint64_t dequeued;  //Ѿȡִе
+		double avgWaitMs;   //ƽŶʱ
+		double maxWaitMs;   //Ŷʱ
+	};
+
+	//ûύҲûù⻧ȫ0˴⻧
+	TenantStats getTenantStats(TenantId tenantId)
+	{
+		std::lock_guard<std::mutex> lock(taskQueMtx_);
+		TenantStats stats{};
+		auto it = tenants_.find(tenantId);
+		if (it == tenants_.end())
+		{
+			return stats;
+		}
+		const TenantState* tenant = it->second.get();
+		stats.queueSize = tenant->que.size();
+		stats.inFlight = tenant->inFlight;
+		stats.dequeued = tenant->dequeued;
+		stats.avgWaitMs = tenant->dequeued == 0 ? 0.0 : tenant->totalWaitNs / 1e6 / tenant->dequeued;
+		stats.maxWaitMs = tenant->maxWaitNs / 1e6;
+		return stats;
+	}
+
+#ifdef __linux__
+	//fdĻصͣΪfd
+	using IoCallback = std::function<void(int)>;
+
+	//עfdɶص̳߳õreactorͶݵִ߳
+	//ñشfdΪصҪһֱEAGAIN
+	bool onReadable(int fd, IoCallback cb)
+	{
+		return registerIo(fd, EPOLLIN, std::move(cb));
+	}
+
+	//עfdдصдصֻһΣдEAGAINҪٴע
+	bool onWritable(int fd, IoCallback cb)
+	{
+		return registerIo(fd, EPOLLOUT, std::move(cb));
+	}
+
+	//ȡfdлصرfd֮ǰҪȵ
+	void removeFd(int fd)
+	{
+		std::lock_guard<std::mutex> lock(ioMtx_);
+		auto it = ioHandlers_.find(fd);
+		if (it == ioHandlers_.end())
+		{
+			return;
+		}
+		it->second->removed = true;
+		ioHandlers_.erase(it);
+		::epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+	}
+#endif
+
+	BasicThreadPool(const BasicThreadPool&) = delete;
+	BasicThreadPool& operator=(const BasicThreadPool&) = delete;
+
+private:
+	using Task = TaskStorage;
+	using Clock = std::chrono::steady_clock;
+
+	struct TenantState;
+
+	//еԪأ¼ʱͽֹʱ
+	struct QueuedTask
+	{
+		Task func;
+		Clock::time_point enqueueTime; //ֻCoDel׼롢¼켣⻧ż¼
+		Clock::time_point deadline;    //time_point::max()ʾûнֹʱ
+		TenantState* tenant = nullptr; //в޵⻧ִҪ黹
+		const char* taskClass = nullptr; //࣬¼켣ãָtypeidֲÿ
+	};
+
+	//һ⻧к͵״̬inFlightⶼtaskQueMtx_
+	struct TenantState
+	{
+		std::queue<QueuedTask> que;
+		int weight = 1; //ÿֿȡ
+		int deficit = 0; //ֻȡ
+		std::atomic_int maxInFlight{ 0 };
+		std::atomic_int inFlight{ 0 };
+		int maxQueued = 0; //Ŷӵޣ0ʾtaskQueMaxThreshHold_һ
+		bool isActive = false; //activeTenants_
+		bool isParked = false; //ﵽޱ𣬶еʱִ
+		uint64_t dequeued = 0;
+		double totalWaitNs = 0;
+		double maxWaitNs = 0;
+	};
+
+	//ÿ߳ԼУqueplacedisAliveisWaitingtaskQueMtx_
+	struct WorkerState
+	{
+		std::deque<QueuedTask> que; //currentWorker()ύĺԼӶβȡȳ
+		std::deque<QueuedTask> placed; //onWorker()õȽȳһֱ
+		bool isAlive = true;
+		bool isWaiting = false; //ڵȴ񣻻ŲҲڵȴæ
+		std::condition_variable wakeup; //ȴʱøֻ
+		//һȡûִе񣬹̴߳Ӷͷȡ߳̿ʱӶβ͵
+		std::deque<QueuedTask> batch;
+		std::mutex batchMtx; //batchҪͬʱʱȼtaskQueMtx_
+	};
+
+	//ǰ߳ĸ̳߳صĸ߳
+	struct CurrentWorker
+	{
+		const void* pool = nullptr;
+		int index = -1;
+	};
+
+	static CurrentWorker& currentWorker()
+	{
+		static thread_local CurrentWorker current;
+		return current;
+	}
+
+	//߳ʱ±꣬ȸѾ˳̵߳±
+	WorkerState* registerWorker()
+	{
+		std::lock_guard<std::mutex> lock(taskQueMtx_);
+		size_t index = 0;
+		while (index < workers_.size() && workers_[index]->isAlive)
+		{
+			index++;
+		}
+		if (index == workers_.size())
+		{
+			workers_.emplace_back(std::make_unique<WorkerState>());
+		}
+		workers_[index]->isAlive = true;
+		currentWorker() = CurrentWorker{ this, (int)index };
+		return workers_[index].get();
+	}
+
+	//߳˳ʣµ񽻸̣߳÷taskQueMtx_
+	void unregisterWorker()
+	{
+		int index = getWorkerIndex();
+		if (index >= 0)
+		{
+			workers_[index]->isAlive = false;
+			currentWorker() = CurrentWorker();
+			if (!workers_[index]->que.empty() || !workers_[index]->placed.empty())
+			{
+				wakeWorkers();
+			}
+		}
+	}
+
+	//еȴеḶ́߳÷taskQueMtx_
+	void wakeWorkers()
+	{
+		workSeq_++;
+		if constexpr (!WaitPolicy::isSpin)
+		{
+			for (auto& worker : workers_)
+			{
+				if (worker->isWaiting)
+				{
+					worker->wakeup.notify_one();
+				}
+			}
+		}
+	}
+
+	//ֻһ̣߳workerΪnullptrʱһȴе̣߳÷taskQueMtx_
+	void wakeWorker(WorkerState* worker)
+	{
+		workSeq_++;
+		if constexpr (!WaitPolicy::isSpin)
+		{
+			if (worker == nullptr)
+			{
+				auto it = std::find_if(workers_.begin(), workers_.end(), [](const std::unique_ptr<WorkerState>& w) { return w->isWaiting; });
+				worker = it != workers_.end() ? it->get() : nullptr;
+			}
+			if (worker != nullptr)
+			{
+				worker->wakeup.notify_one();
+			}
+		}
+	}
+
+	//÷ʽҵӦ÷ľֲУnullptrʾͨ
+	//ŵ߳ԼĶʱownerΪṆ̀߳÷taskQueMtx_
+	std::deque<QueuedTask>* localQueueFor(const TaskPlacement& placement, WorkerState*& owner)
+	{
+		owner = nullptr;
+		switch (placement.kind)
+		{
+		case PlacementKind::PLACE_CURRENT_WORKER:
+		{
+			int index = getWorkerIndex();
+			owner = index >= 0 ? workers_[index].get() : nullptr;
+			return owner != nullptr ? &owner->que : nullptr;
+		}
+		case PlacementKind::PLACE_WORKER:
+			if (placement.worker >= 0 && placement.worker < (int)workers_.size() && workers_[placement.worker]->isAlive)
+			{
+				owner = workers_[placement.worker].get();
+				return &owner->placed;
+			}
+			return nullptr;
+		case PlacementKind::PLACE_SAME_GROUP:
+			//ֻһʱͨû
+			if (groupQues_.size() > 1)
+			{
+				return &groupQues_[CpuTopology::instance().currentGroup()];
+			}
+			return nullptr;
+		default:
+			return nullptr;
+		}
+	}
+
+	//ȡһж˻̵߳batch͵ûпִеʱfalse
+	//stealAtΪ̵߳ķԱ͵ߵʱ䣬÷taskQueMtx_
+	bool popTask(QueuedTask& task, Clock::time_point& stealAt)
+	{
+		if (popQueuedTask(task, stealAt))
+		{
+			taskSize_--;
+			return true;
+		}
+		return stealBatchTask(task);
+	}
+
+	//ȡԼµĺķȡǰȡͨ⻧
+	//̺߳Ķ͵񣬵÷taskQueMtx_
+	bool popQueuedTask(QueuedTask& task, Clock::time_point& stealAt)
+	{
+		stealAt = Clock::time_point::max();
+		//ֻзʱҪ֪ǰڵĻûзʱsched_getcpu
+		int group = 0;
+		if (localTaskSize_ > 0)
+		{
+			int index = getWorkerIndex();
+			if (index >= 0 && !workers_[index]->que.empty())
+			{
+				task = popLocalTask(workers_[index]->que, false);
+				return true;
+			}
+			if (index >= 0 && !workers_[index]->placed.empty())
+			{
+				task = popLocalTask(workers_[index]->placed, true);
+				return true;
+			}
+			if (groupQues_.size() > 1)
+			{
+				group = CpuTopology::instance().currentGroup();
+				if (!groupQues_[group].empty())
+				{
+					task = popLocalTask(groupQues_[group], true);
+					return true;
+				}
+			}
+		}
+		if (hasSharedTask())
+		{
+			task = popNextTask();
+			return true;
+		}
+		if (localTaskSize_ == 0)
+		{
+			return false;
+		}
+		//е̻߳Լȡøæ̺߳ǣŶӳLOCAL_STEAL_DELAY_US͵
+		Clock::time_point now = Clock::now();
+		for (auto& worker : workers_)
+		{
+			if (worker->isAlive && worker->isWaiting)
+			{
+				continue;
+			}
+			//Ѿ˳̲߳ȡԼ񣬲õ
+			for (std::deque<QueuedTask>* que : { &worker->placed, &worker->que })
+			{
+				if (!worker->isAlive ? !que->empty() : canSteal(*que, now, stealAt))
+				{
+					task = popLocalTask(*que, true);
+					return true;
+				}
+			}
+		}
+		for (size_t i = 0; i < groupQues_.size(); i++)
+		{
+			if ((int)i != group && canSteal(groupQues_[i], now, stealAt))
+			{
+				task = popLocalTask(groupQues_[i], true);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	//̵߳ķѾŶӹã͵ʱ
+	static bool canSteal(const std::deque<QueuedTask>& que, Clock::time_point now, Clock::time_point& stealAt)
+	{
+		if (que.empty())
+		{
+			return false;
+		}
+		Clock::time_point at = que.front().enqueueTime + std::chrono::microseconds(LOCAL_STEAL_DELAY_US);
+		if (at <= now)
+		{
+			return true;
+		}
+		stealAt = std::min(stealAt, at);
+		return false;
+	}
+
+	//̵߳batchβ͵һǸִ̻߳batchǰ
+	//͵ĻһִкܾûȴῨס񣬵÷taskQueMtx_
+	bool stealBatchTask(QueuedTask& task)
+	{
+		if (batchedTaskSize_ == 0)
+		{
+			return false;
+		}
+		for (auto& worker : workers_)
+		{
+			std::lock_guard<std::mutex> lock(worker->batchMtx);
+			if (!worker->batch.empty())
+			{
+				task = std::move(worker->batch.back());
+				worker->batch.pop_back();
+				batchedTaskSize_--;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	//̰߳˳ȡԼbatchеһ񣬲ҪtaskQueMtx_
+	bool popBatchTask(WorkerState* self, QueuedTask& task)
+	{
+		if (self == nullptr)
+		{
+			return false;
+		}
+		std::lock_guard<std::mutex> lock(self->batchMtx);
+		if (self->batch.empty())
+		{
+			return false;
+		}
+		task = std::move(self->batch.front());
+		self->batch.pop_front();
+		batchedTaskSize_--;
+		return true;
+	}
+
+	QueuedTask popLocalTask(std::deque<QueuedTask>& que, bool isFront)
+	{
+		QueuedTask task = std::move(isFront ? que.front() : que.back());
+		if (isFront)
+		{
+			que.pop_front();
+		}
+		else
+		{
+			que.pop_back();
+		}
+		localTaskSize_--;
+		return task;
+	}
+
+	//÷taskQueMtx_
+	TenantState* getTenant(TenantId tenantId)
+	{
+		auto& tenant = tenants_[tenantId];
+		if (tenant == nullptr)
+		{
+			tenant = std::make_unique<TenantState>();
+		}
+		return tenant.get();
+	}
+
+	//ͨ߻Ծ⻧񣬵÷taskQueMtx_
+	bool hasSharedTask() const
+	{
+		return taskQue_.size() > 0 || !activeTenants_.empty();
+	}
+
+	//ִе̺߳ͻеԼ߳batchп͵񣬵÷taskQueMtx_
+	bool hasRunnableTask() const
+	{
+		return hasSharedTask() || localTaskSize_ > 0 || batchedTaskSize_ > 0;
+	}
+
+	//ͨС̺߳ͻеڶжϣ÷taskQueMtx_
+	size_t queuedTaskSize() const
+	{
+		return taskQue_.size() + localTaskSize_;
+	}
+
+	//Ƿпࣺ⻧ֻԼĶбȽϣһ⻧ѹ񣨰ģ
+	//⻧ͨύʧܣtenantΪnullptrʾͨ񣬵÷taskQueMtx_
+	bool hasRoomFor(const TenantState* tenant) const
+	{
+		if (tenant == nullptr)
+		{
+			return queuedTaskSize() < (size_t)taskQueMaxThreshHold_;
+		}
+		size_t limit = tenant->maxQueued > 0 ? tenant->maxQueued : taskQueMaxThreshHold_;
+		return tenant->que.size() < limit;
+	}
+
+	//⻧ת÷taskQueMtx_
+	void activateTenant(TenantState* tenant)
+	{
+		if (tenant->isActive)
+		{
+			return;
+		}
+		tenant->isActive = true;
+		tenant->deficit = 0;
+		activeTenants_.push_back(tenant);
+		//⻧תͨΪĬ⻧ҲҪת
+		if (tenant != &defaultTenant_ && taskQue_.size() > 0)
+		{
+			activateTenant(&defaultTenant_);
+		}
+	}
+
+	//⻧ӣ÷taskQueMtx_
+	void enqueueTenantTask(TenantState* tenant, QueuedTask&& task)
+	{
+		task.tenant = tenant;
+		tenant->que.emplace(std::move(task));
+		if (tenant->isParked)
+		{
+			return;
+		}
+		//ȡʱ⻧ֻ˳תûйʱܻڲϣҪȹ
+		if (tenant->maxInFlight > 0 && tenant->inFlight >= tenant->maxInFlight)
+		{
+			tenant->isParked = true;
+			return;
+		}
+		taskSize_++;
+		activateTenant(tenant);
+	}
+
+	//ȡһû⻧ʱֱȡͨУdeficit round robinת
+	//activeTenants_е⻧ûдﵽޣÿȡO(1)÷taskQueMtx_
+	QueuedTask popNextTask()
+	{
+		if (activeTenants_.empty())
+		{
+			QueuedTask task = std::move(taskQue_.front());
+			taskQue_.pop();
+			return task;
+		}
+
+		TenantState* tenant = activeTenants_.front();
+		if (tenant->deficit <= 0)
+		{
+			tenant->deficit += tenant->weight;
+		}
+		tenant->deficit--;
+
+		QueuedTask task;
+		bool isEmpty;
+		if (tenant == &defaultTenant_)
+		{
+			task = std::move(taskQue_.front());
+			taskQue_.pop();
+			isEmpty = taskQue_.size() == 0;
+		}
+		else
+		{
+			task = std::move(tenant->que.front());
+			tenant->que.pop();
+			isEmpty = tenant->que.empty();
+
+			double waitNs = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - task.enqueueTime).count();
+			tenant->dequeued++;
+			tenant->totalWaitNs += waitNs;
+			tenant->maxWaitNs = std::max(tenant->maxWaitNs, waitNs);
+			if (tenant->maxInFlight > 0)
+			{
+				tenant->inFlight++;
+			}
+			else
+			{
+				//ûвޣִ겻Ҫ黹
+				task.tenant = nullptr;
+			}
+		}
+
+		bool isFull = tenant->maxInFlight > 0 && tenant->inFlight >= tenant->maxInFlight;
+		if (isEmpty || isFull)
+		{
+			activeTenants_.pop_front();
+			tenant->isActive = false;
+			if (!isEmpty)
+			{
+				//ﵽޣʣµʱִ
+				tenant->isParked = true;
+				taskSize_ -= (int)tenant->que.size();
+			}
+		}
+		else if (tenant->deficit <= 0)
+		{
+			//ֵ꣬һ⻧
+			activeTenants_.pop_front();
+			activeTenants_.push_back(tenant);
+		}
+		return task;
+	}
+
+	//в޵⻧ִ꣬黹⻧ִָܻ
+	void finishTenantTask(TenantState* tenant)
+	{
+		std::lock_guard<std::mutex> lock(taskQueMtx_);
+		tenant->inFlight--;
+		resumeTenantIfPossible(tenant);
+	}
+
+	//÷taskQueMtx_
+	void resumeTenantIfPossible(TenantState* tenant)
+	{
+		if (!tenant->isParked || (tenant->maxInFlight > 0 && tenant->inFlight >= tenant->maxInFlight))
+		{
+			return;
+		}
+		tenant->isParked = false;
+		taskSize_ += (int)tenant->que.size();
+		activateTenant(tenant);
+		wakeWorkers();
+	}
+
+	//submitShared;Ԫ
+	struct SharedEntry
+	{
+		std::shared_ptr<void> result; //ָstd::shared_future<RType>
+		std::type_index type; //RTypeֹͬһkeyòͬķֵ
+		Clock::time_point expireAt; //;ʱΪtime_point::max()
+	};
+
+	struct SharedShard
+	{
+		std::mutex mtx;
+		std::unordered_map<std::string, SharedEntry> entries;
+		size_t sweepSize = SHARED_SWEEP_SIZE;
+	};
+
+	//û쳣ɹʧܵĽ
+	template<typename RType>
+	static bool isReady(const std::shared_future<RType>& result)
+	{
+		try
+		{
+			result.get();
+			return true;
+		}
+		catch (...)
+		{
+			return false;
+		}
+	}
+
+	//ֱttlߴ;ɾ
+	//keyѾµ񸲸ǣֻԼһ
+	void finishShared(SharedShard& shard, const std::string& key, const std::shared_ptr<void>& result, bool succeeded)
+	{
+		std::lock_guard<std::mutex> lock(shard.mtx);
+		auto it = shard.entries.find(key);
+		if (it == shard.entries.end() || it->second.result != result)
+		{
+			return;
+		}
+		Clock::duration ttl = sharedResultTTL_.load();
+		if (succeeded && ttl > Clock::duration::zero())
+		{
+			it->second.expireAt = Clock::now() + ttl;
+		}
+		else
+		{
+			shard.entries.erase(it);
+		}
+	}
+
+	//ƬйڵĻ÷shard.mtx
+	void sweepShared(SharedShard& shard, Clock::time_point now)
+	{
+		for (auto it = shard.entries.begin(); it != shard.entries.end();)
+		{
+			if (it->second.expireAt <= now)
+			{
+				it = shard.entries.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+		//ʣµĶ;δڵģ´ζһЩ
+		shard.sweepSize = std::max(SHARED_SWEEP_SIZE, shard.entries.size() * 2);
+	}
+
+	//submitHedgedһִй
+	template<typename RType, typename F>
+	struct HedgeState
+	{
+		HedgeState(F&& f, const char* cls)
+			:func(std::move(f))
+			, taskClass(cls)
+		{}
+
+		F func;
+		const char* taskClass;
+		std::promise<RType> promise;
+		std::atomic_bool isDone{ false }; //Ѿһִ
+		std::atomic_bool isStarted{ false }; //һѾʼִ
+	};
+
+	//һִʱ
+	struct HedgeHistory
+	{
+		std::vector<int64_t> samples; //λ
+		size_t next = 0;
+		size_t fresh = 0; //ϴμλ֮
+		int64_t percentileNs = 0; //0ʾ
+	};
+
+	//ύһִУܾʱfalse
+	template<typename State>
+	bool submitAttempt(const std::shared_ptr<State>& state)
+	{
+		return trySubmit([this, state]() {
+			runAttempt(*state);
+		});
+	}
+
+	template<typename RType, typename F>
+	void runAttempt(HedgeState<RType, F>& state)
+	{
+		if (state.isDone)
+		{
+			//һѾɣûʼݲִ
+			return;
+		}
+		//ԳǷֻڵһݿʼԺύ
+		bool isPrimary = !state.isStarted.exchange(true);
+		bool isRecorded = isPrimary;
+		auto start = Clock::now();
+		const std::atomic_bool*& flag = currentCancelFlag();
+		const std::atomic_bool* outer = flag;
+		flag = &state.isDone;
+		try
+		{
+			if constexpr (std::is_void<RType>::value)
+			{
+				state.func();
+				if (!state.isDone.exchange(true))
+				{
+					state.promise.set_value();
+				}
+			}
+			else
+			{
+				RType value = state.func();
+				if (!state.isDone.exchange(true))
+				{
+					state.promise.set_value(std::move(value));
+				}
+			}
+		}
+		catch (...)
+		{
+			if (!state.isDone.exchange(true))
+			{
+				state.promise.set_exception(std::current_exception());
+				isRecorded = false;
+			}
+		}
+		flag = outer;
+		//ʷִʱֻǵһݴӿʼʱ䣺ֻӮǷݵĻԳӮʱԳǰȵʱ䣬λԽԽС
+		//һݱǰʱµʱҲڴʼõʱ
+		if (isRecorded)
+		{
+			recordHedgeTime(state.taskClass, Clock::now() - start);
+		}
+	}
+
+	//ʱڣһݻִоύһ
+	template<typename State>
+	void maybeHedge(const std::shared_ptr<State>& state)
+	{
+		//Ѿɣ߻ŶӣύһҲֻ
+		if (state->isDone || !state->isStarted)
+		{
+			return;
+		}
+		if ((hedgesLaunched_ + 1) * 100 > hedgedCalls_ * (uint64_t)hedgeBudgetPercent_)
+		{
+			return;
+		}
+		//ѾŶӣ˵ûп̣߳Գֻظ
+		bool isBacklogged;
+		if constexpr (QueuePolicy::isLockFree)
+		{
+			isBacklogged = !taskQue_.empty();
+		}
+		else
+		{
+			isBacklogged = taskSize_ > 0 || batchedTaskSize_ > 0;
+		}
+		if (isBacklogged)
+		{
+			return;
+		}
+		hedgesLaunched_++;
+		submitAttempt(state);
+	}
+
+	//Գӳ٣afterʷִʱλĽСֵ
+	Clock::duration hedgeDelay(const char* taskClass, std::chrono::nanoseconds after)
+	{
+		std::lock_guard<std::mutex> lock(hedgeMtx_);
+		auto it = hedgeHistory_.find(taskClass);
+		if (it == hedgeHistory_.end() || it->second.percentileNs == 0)
+		{
+			return after;
+		}
+		return std::min<Clock::duration>(after, std::chrono::nanoseconds(it->second.percentileNs));
+	}
+
+	void recordHedgeTime(const char* taskClass, Clock::duration dur)
+	{
+		std::lock_guard<std::mutex> lock(hedgeMtx_);
+		HedgeHistory& history = hedgeHistory_[taskClass];
+		int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(dur).count();
+		if (history.samples.size() < HEDGE_HISTORY_SIZE)
+		{
+			history.samples.push_back(ns);
+		}
+		else
+		{
+			history.samples[history.next] = ns;
+			history.next = (history.next + 1) % HEDGE_HISTORY_SIZE;
+		}
+		if (++history.fresh < HEDGE_MIN_SAMPLES)
+		{
+			return;
+		}
+		//ܹһ¼λ
+		history.fresh = 0;
+		std::vector<int64_t> sorted = history.samples;
+		size_t k = sorted.size() * HEDGE_PERCENTILE / 100;
+		std::nth_element(sorted.begin(), sorted.begin() + k, sorted.end());
+		history.percentileNs = std::max<int64_t>(sorted[k], 1);
+	}
+
+	//ڶʱ߳ϵʱִfuncʱ̵߳һʹʱ
+	void addTimer(Clock::time_point when, std::function<void()> func)
+	{
+		std::lock_guard<std::mutex> lock(timerMtx_);
+		if (isTimerStopped_)
+		{
+			return;
+		}
+		if (!timerThread_.joinable())
+		{
+			timerThread_ = std::thread(&BasicThreadPool::timerFunc, this);
+		}
+		timers_.emplace(when, std::move(func));
+		timerCond_.notify_one();
+	}
+
+	void timerFunc()
+	{
+		std::unique_lock<std::mutex> lock(timerMtx_);
+		while (!isTimerStopped_)
+		{
+			if (timers_.empty())
+			{
+				timerCond_.wait(lock);
+				continue;
+			}
+			auto it = timers_.begin();
+			if (Clock::now() < it->first)
+			{
+				timerCond_.wait_until(lock, it->first);
+				continue;
+			}
+			std::function<void()> func = std::move(it->second);
+			timers_.erase(it);
+			lock.unlock();
+			func();
+			lock.lock();
+		}
+	}
+
+	//ֹͣʱ̣߳ûڵĶʱֱӶ
+	void stopTimer()
+	{
+		{
+			std::lock_guard<std::mutex> lock(timerMtx_);
+			isTimerStopped_ = true;
+			timers_.clear();
+			timerCond_.notify_one();
+		}
+		if (timerThread_.joinable())
+		{
+			timerThread_.join();
+		}
+	}
+
+	//ģʽǳfixedģʽ·ûģʽж
+	bool isCachedMode() const
+	{
+		if constexpr (GrowthPolicy::isRuntime)
+		{
+			return poolMode_ == PoolMode::MODE_CACHED;
+		}
+		else
+		{
+			return GrowthPolicy::mode == PoolMode::MODE_CACHED;
+		}
+	}
+
+	//ֻп߳ʱҪά߳
+	static constexpr bool tracksIdleThreads()
+	{
+		return GrowthPolicy::isRuntime || GrowthPolicy::mode == PoolMode::MODE_CACHED;
+	}
+
+	//ύܾʱظ÷futureѾֵǷֵ͵Ĭֵ
+	template<typename RType>
+	static std::future<RType> rejectedFuture()
+	{
+		std::packaged_task<RType()> task([]()->RType { return RType(); });
+		std::future<RType> result = task.get_future();
+		task();
+		return result;
+	}
+
+	//packaged_taskŽ洢ͣstd::functionҪɿҪshared_ptrһ
+	template<typename RType>
+	static Task wrapTask(std::packaged_task<RType()>&& task)
+	{
+		if constexpr (std::is_copy_constructible<Task>::value)
+		{
+			auto sp = std::make_shared<std::packaged_task<RType()>>(std::move(task));
+			return [sp]() { (*sp)(); };
+		}
+		else
+		{
+			return Task(std::move(task));
+		}
+	}
+
+	//Уtimeout߹ʱfalse
+	//timeoutΪ0ʱȴҲӡύʧܵ־ɵ÷Լ
+	bool pushTask(QueuedTask&& task, TenantId tenantId, const TaskPlacement& placement = TaskPlacement(),
+		std::chrono::milliseconds timeout = std::chrono::milliseconds(SUBMIT_TIMEOUT_MS))
+	{
+		bool isQuiet = timeout.count() == 0;
+		if constexpr (QueuePolicy::isLockFree)
+		{
+			//ʱóCPUԣtimeout
+			if (!taskQue_.tryPush(std::move(task)))
+			{
+				auto end = Clock::now() + timeout;
+				while (!taskQue_.tryPush(std::move(task)))
+				{
+					if (Clock::now() >= end)
+					{
+						if (!isQuiet)
+						{
+							std::cerr << "task queue is full, submit task faill." << std::endl;
+						}
+						return false;
+					}
+					std::this_thread::yield();
+				}
+			}
+			afterLockFreePush();
+			return true;
+		}
+		else
+		{
+			//ȡ
+			std::unique_lock<std::mutex> lock(taskQueMtx_);
+			TenantState* tenant = tenantId == NO_TENANT ? nullptr : getTenant(tenantId);
+
+			//߳ͨţȴп  notFull_
+			//ûύtimeout,жύʧܣ
+			if (!notFull_.wait_for(lock, timeout,
+				[&]()->bool {return hasRoomFor(tenant); }))
+			{
+				//ʾnotFull_ȴtimeoutȻû
+				if (!isQuiet)
+				{
+					std::cerr << "task queue is full, submit task faill." << std::endl;
+				}
+				return false;
+			}
+
+			//Ŷʱ꣬˵Ѿأܾ
+			if (admissionMode_ == AdmissionMode::ADMIT_CODEL && isOverloaded_)
+			{
+				if (!isQuiet)
+				{
+					std::cerr << "task queue is overloaded, submit task faill." << std::endl;
+				}
+				return false;
+			}
+
+			//п࣬ŵ
+			WorkerState* owner = nullptr;
+			std::deque<QueuedTask>* localQue = localQueueFor(placement, owner);
+			if (localQue != nullptr)
+			{
+				localQue->emplace_back(std::move(task));
+				localTaskSize_++;
+				taskSize_++;
+			}
+			else if (tenant == nullptr)
+			{
+				taskQue_.emplace(std::move(task));
+				taskSize_++;
+				if (!activeTenants_.empty())
+				{
+					activateTenant(&defaultTenant_);
+				}
+			}
+			else
+			{
+				enqueueTenantTask(tenant, std::move(task));
+			}
+
+			//Ϊп϶ˣ֪ͨȴ߳
+			//ø̵ֻ߳Ŀ߳æʱһ̣߳ʱ͵
+			if (owner != nullptr)
+			{
+				wakeWorker(owner->isWaiting ? owner : nullptr);
+			}
+			else
+			{
+				wakeWorkers();
+			}
+
+			//ҪͿ̵߳жǷҪµ̳߳
+			growIfNeeded();
+			return true;
+		}
+	}
+
+	//з󣺻̣߳cachedģʽжǷҪ߳
+	void afterLockFreePush()
+	{
+		if (tracksIdleThreads())
+		{
+			taskSize_++;
+		}
+		if constexpr (!WaitPolicy::isSpin)
+		{
+			//waitLockFreeеդԣ֤Ҫô￴sleepers_Ҫôȴ
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (sleepers_.load(std::memory_order_relaxed) > 0)
+			{
+				std::lock_guard<std::mutex> lock(taskQueMtx_);
+				notEmpty_.notify_one();
+			}
+		}
+		if (isCachedMode() && taskSize_ > idleThreadSize_ && curThreadSize_ < threadSizeThreshHold_)
+		{
+			std::lock_guard<std::mutex> lock(taskQueMtx_);
+			growIfNeeded();
+		}
+	}
+
+	Clock::time_point enqueueTime() const
+	{
+		bool isNeeded = admissionMode_ == AdmissionMode::ADMIT_CODEL || recorder_.load(std::memory_order_relaxed) != nullptr;
+		return isNeeded ? Clock::now() : Clock::time_point();
 	}
 
-	ThreadPool(const ThreadPool&) = delete;
-	ThreadPool& operator=(const ThreadPool&) = delete;
+	//CoDelݳŶʱ¹״̬÷taskQueMtx_
+	void updateOverloadState(const QueuedTask& task, Clock::time_point now)
+	{
+		if (now - task.enqueueTime < codelTarget_ || !hasRunnableTask())
+		{
+			//Ŷʱ併Ŀֵ»߶Ѿգ˳״̬
+			firstAboveTime_ = Clock::time_point();
+			isOverloaded_ = false;
+		}
+		else if (firstAboveTime_ == Clock::time_point())
+		{
+			firstAboveTime_ = now + codelInterval_;
+		}
+		else if (now >= firstAboveTime_)
+		{
+			isOverloaded_ = true;
+		}
+	}
 
-private:
-	//߳
-	void threadFunc(int threadid)
+	//cachedģʽ¸Ϳ̣߳߳÷taskQueMtx_
+	void growIfNeeded()
 	{
-		auto lastTime = std::chrono::high_resolution_clock().now();
+		if (isCachedMode()
+			&& taskSize_ > idleThreadSize_
+			&& curThreadSize_ < threadSizeThreshHold_
+			&& (budget_ == nullptr || budget_->hasCapacity()))
+		{
+			std::cout << ">>>>>create new thread...." << std::endl;
+			//̶߳
+			auto ptr = std::make_unique<Thread>(std::bind(&BasicThreadPool::threadFunc, this, std::placeholders::_1));
+			int threadId = ptr->getId();
+			threads_.emplace(threadId, std::move(ptr));
+			threads_[threadId]->start();//߳
 
-		for (;;)
+			//޸̸߳ر
+			curThreadSize_++; //ǰ߳
+			idleThreadSize_++;//߳
+		}
+	}
+
+	//һμһУreactorͶݾ¼ʹ
+	//ʱһֱȴ¼submitTask
+	void submitBatch(std::vector<Task>& batch)
+	{
+		if (batch.empty())
+		{
+			return;
+		}
+		if constexpr (QueuePolicy::isLockFree)
+		{
+			for (auto& task : batch)
+			{
+				QueuedTask entry{ std::move(task), Clock::time_point(), Clock::time_point::max() };
+				while (!taskQue_.tryPush(std::move(entry)))
+				{
+					std::this_thread::yield();
+				}
+				afterLockFreePush();
+			}
+		}
+		else
 		{
-			Task task;
-			{
-				//Ȼȡ
-				std::unique_lock<std::mutex> lock(taskQueMtx_);
-				std::cout << "tid:" << std::this_thread::get_id() << "Իȡ..." << std::endl;
-				//cachedģʽ£пѾ˺̡ܶ߳
-				//ǿʱ䳬60sӦðѶ߳̽յ
-				//initThreadSize_߳Ҫл
-				//ǰʱ - һִ߳ʱ > 60s
-				// + ˫ж 
-				while (taskQue_.size() == 0)
+			std::unique_lock<std::mutex> lock(taskQueMtx_);
+			for (auto& task : batch)
+			{
+				notFull_.wait(lock, [&]()->bool { return queuedTaskSize() < (size_t)taskQueMaxThreshHold_; });
+				taskQue_.emplace(QueuedTask{ std::move(task), enqueueTime(), Clock::time_point::max() });
+				taskSize_++;
+				if (!activeTenants_.empty())
 				{
-					//̳߳Ҫ߳Դ
-					if (!isPoolRunning_) {
-						threads_.erase(threadid);
-						std::cout << "threadid:" << std::this_thread::get_id() << "exit!" << std::endl;
-						exitCond_.notify_all();
-						return;
-					}
-					if (poolMode_ == PoolMode::MODE_CACHED)
+					activateTenant(&defaultTenant_);
+				}
+			}
+			wakeWorkers();
+			growIfNeeded();
+		}
+		batch.clear();
+	}
+
+#ifdef __linux__
+	//һfdעĻص
+	struct IoHandler
+	{
+		int fd;
+		uint32_t events = 0; //ע¼ EPOLLIN / EPOLLOUT
+		IoCallback onRead;
+		IoCallback onWrite;
+		bool inFlight = false; //¼ѾͶݡصŶлִУʱ¹¼
+		std::atomic_bool removed{ false };
+	};
+
+	bool registerIo(int fd, uint32_t event, IoCallback cb)
+	{
+		std::lock_guard<std::mutex> lock(ioMtx_);
+		if (!startReactor())
+		{
+			return false;
+		}
+		auto& handler = ioHandlers_[fd];
+		bool isNew = (handler == nullptr);
+		if (isNew)
+		{
+			handler = std::make_shared<IoHandler>();
+			handler->fd = fd;
+		}
+		if (event == EPOLLIN)
+		{
+			handler->onRead = std::move(cb);
+		}
+		else
+		{
+			handler->onWrite = std::move(cb);
+		}
+		handler->events |= event;
+		if (handler->inFlight)
+		{
+			//صִᰴµevents¹
+			return true;
+		}
+
+		//ONESHOT֤ͬһfdĻصͬʱִ߳Уصִ¹
+		epoll_event ev{};
+		ev.events = handler->events | EPOLLET | EPOLLONESHOT;
+		ev.data.fd = fd;
+		if (::epoll_ctl(epollFd_, isNew ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fd, &ev) < 0)
+		{
+			std::cerr << "epoll_ctl fail, fd:" << fd << " errno:" << errno << std::endl;
+			if (isNew)
+			{
+				ioHandlers_.erase(fd);
+			}
+			return false;
+		}
+		return true;
+	}
+
+	//reactoṛ߳÷ioMtx_
+	bool startReactor()
+	{
+		if (epollFd_ >= 0)
+		{
+			return true;
+		}
+		epollFd_ = ::epoll_create1(EPOLL_CLOEXEC);
+		wakeFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (epollFd_ < 0 || wakeFd_ < 0)
+		{
+			std::cerr << "reactor create fail, errno:" << errno << std::endl;
+			closeReactorFds();
+			return false;
+		}
+		//eventfdˮƽepoll_waitϵreactor߳
+		epoll_event ev{};
+		ev.events = EPOLLIN;
+		ev.data.fd = wakeFd_;
+		::epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &ev);
+
+		isReactorRunning_ = true;
+		reactorThread_ = std::thread(&BasicThreadPool::reactorFunc, this);
+		return true;
+	}
+
+	void stopReactor()
+	{
+		{
+			std::lock_guard<std::mutex> lock(ioMtx_);
+			if (!isReactorRunning_)
+			{
+				return;
+			}
+			isReactorRunning_ = false;
+			uint64_t one = 1;
+			(void)::write(wakeFd_, &one, sizeof(one));
+		}
+		reactorThread_.join();
+
+		std::lock_guard<std::mutex> lock(ioMtx_);
+		for (auto& entry : ioHandlers_)
+		{
+			entry.second->removed = true;
+		}
+		ioHandlers_.clear();
+		closeReactorFds();
+	}
+
+	void closeReactorFds()
+	{
+		if (epollFd_ >= 0)
+		{
+			::close(epollFd_);
+		}
+		if (wakeFd_ >= 0)
+		{
+			::close(wakeFd_);
+		}
+		epollFd_ = -1;
+		wakeFd_ = -1;
+	}
+
+	//reactoṛ߳ȴfdһepoll_waitõ¼Ͷݵ
+	void reactorFunc()
+	{
+		epoll_event events[REACTOR_MAX_EVENTS];
+		std::vector<Task> batch;
+		batch.reserve(REACTOR_MAX_EVENTS);
+
+		while (isReactorRunning_)
+		{
+			int n = ::epoll_wait(epollFd_, events, REACTOR_MAX_EVENTS, -1);
+			if (n < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				std::cerr << "epoll_wait fail, errno:" << errno << std::endl;
+				break;
+			}
+			{
+				std::lock_guard<std::mutex> lock(ioMtx_);
+				for (int i = 0; i < n; i++)
+				{
+					int fd = events[i].data.fd;
+					if (fd == wakeFd_)
 					{
-						if (std::cv_status::timeout ==
-							notEmpty_.wait_for(lock, std::chrono::seconds(1)))
-						{
-							auto now = std::chrono::high_resolution_clock().now();
-							auto dur = std::chrono::duration_cast<std::chrono::seconds>(now - lastTime);
-							if (dur.count() >= THREAD_MAX_IDLE_TIME
-								&& curThreadSize_ > initThreadSize_)
-							{
-								//ʼյǰ߳
-								//1.¼߳رб仯
-
-								//2.̶߳߳бɾ
-								threads_.erase(threadid);
-								curThreadSize_--;
-								idleThreadSize_--;
-								std::cout << "threadid:" << std::this_thread::get_id() << "exit!" << std::endl;
-								return;
-							}
-						}
+						uint64_t cnt;
+						(void)::read(wakeFd_, &cnt, sizeof(cnt));
+						continue;
 					}
-					else
+					auto it = ioHandlers_.find(fd);
+					if (it == ioHandlers_.end())
 					{
-						//ȴnotEmpty
-						notEmpty_.wait(lock);
+						continue;
 					}
+					std::shared_ptr<IoHandler> handler = it->second;
+					uint32_t revents = events[i].events;
+					//Ͷݿʼ;صŶʱעҲ¼ͬһfdĻصͬʱִ
+					handler->inFlight = true;
+					batch.emplace_back([this, handler, revents]() { runIoHandler(handler, revents); });
 				}
+			}
+			submitBatch(batch);
+		}
+	}
+
+	//ڹִ߳fdĻصִ¹ONESHOT¼
+	void runIoHandler(const std::shared_ptr<IoHandler>& handler, uint32_t revents)
+	{
+		//Ҷʱصãûread/writeõ
+		bool failed = (revents & (EPOLLERR | EPOLLHUP)) != 0;
+		IoCallback onRead, onWrite;
+		{
+			//صִڼ䱻עᣬȡһ
+			std::lock_guard<std::mutex> lock(ioMtx_);
+			if (revents & EPOLLIN || failed)
+			{
+				onRead = handler->onRead;
+			}
+			if ((revents & EPOLLOUT || failed) && (handler->events & EPOLLOUT))
+			{
+				//дһԵģfdһֱд᲻ͣش
+				onWrite = std::move(handler->onWrite);
+				handler->onWrite = nullptr;
+				handler->events &= ~EPOLLOUT;
+			}
+		}
+		if (onRead && !handler->removed)
+		{
+			onRead(handler->fd);
+		}
+		if (onWrite && !handler->removed)
+		{
+			onWrite(handler->fd);
+		}
+
+		std::lock_guard<std::mutex> lock(ioMtx_);
+		handler->inFlight = false;
+		if (handler->removed || epollFd_ < 0 || handler->events == 0)
+		{
+			return;
+		}
+		epoll_event ev{};
+		ev.events = handler->events | EPOLLET | EPOLLONESHOT;
+		ev.data.fd = handler->fd;
+		::epoll_ctl(epollFd_, EPOLL_CTL_MOD, handler->fd, &ev);
+	}
+#endif
+
+	//߳
+	void threadFunc(int threadid)
+	{
+		auto lastTime = std::chrono::high_resolution_clock().now();
+		QueuedTask task;
+		WorkerState* self = nullptr; //µǰ̵߳״̬һȡself->batch
+		int64_t avgTaskNs = 0; //ƽʱһȡٸ
+		TraceRecorder* traceRecorder = nullptr; //ǰ̵߳Ĺ켣Ĵμ¼
+		TraceBuffer* traceBuffer = nullptr;
+		if constexpr (!QueuePolicy::isLockFree)
+		{
+			self = registerWorker();
+		}
 
-				idleThreadSize_--; //̼߳1
-				std::cout << "tid:" << std::this_thread::get_id() << "ȡɹ..." << std::endl;
-				//ȡһ
-				task = taskQue_.front();
-				taskQue_.pop();
+		for (;;)
+		{
+			if (!takeTask(threadid, lastTime, self, task, avgTaskNs))
+			{
+				return;
+			}
+			//ִһڼռһԤ
+			if (budget_ != nullptr)
+			{
+				budget_->acquire(budgetMember_);
+			}
+
+			Clock::time_point begin;
+			if constexpr (!QueuePolicy::isLockFree)
+			{
+				begin = Clock::now();
+			}
+			//ûڼ¼ʱֻһԭӶ
+			TraceRecorder* recorder = recorder_.load(std::memory_order_acquire);
+			if (recorder != nullptr && recorder != traceRecorder)
+			{
+				traceRecorder = recorder;
+				traceBuffer = recorder->newBuffer();
+			}
+			//batchʣµܱ߳͵ߣʵִеĸcountΪ׼
+			int64_t count = 0;
+			do
+			{
+				runTask(std::move(task), recorder, traceBuffer, threadid);
+				count++;
+			} while (popBatchTask(self, task));
+			if (budget_ != nullptr)
+			{
+				budget_->release(budgetMember_);
+			}
+			if constexpr (!QueuePolicy::isLockFree)
+			{
+				//ͳƺʱÿȡһʱ
+				int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count() / count;
+				avgTaskNs = (avgTaskNs == 0) ? ns : (avgTaskNs * 7 + ns) / 8;
+			}
+
+			if (tracksIdleThreads())
+			{
+				idleThreadSize_++;
+			}
+			if (isCachedMode())
+			{
+				lastTime = std::chrono::high_resolution_clock().now(); //ִ߳ʱ
+			}
+		}
+	}
+
+	//ִһ񣬹ڵֱӶ
+	void runTask(QueuedTask task, TraceRecorder* recorder, TraceBuffer* traceBuffer, int threadid)
+	{
+		bool isExpired = task.deadline != Clock::time_point::max() && Clock::now() > task.deadline;
+		if (task.func && !isExpired)
+		{
+			if (recorder != nullptr)
+			{
+				recorder->begin(traceBuffer);
+				Clock::time_point start = Clock::now();
+				task.func();
+				recorder->record(traceBuffer, TraceEvent{ task.taskClass, task.enqueueTime, start, Clock::now(), (uint32_t)threadid });
+			}
+			else
+			{
+				//task->run();//ִ񣻰ִķֵͨsetValResult
+				task.func(); //using Task = std::function<void()> packaged_taskõ
+			}
+		}
+		if constexpr (!QueuePolicy::isLockFree)
+		{
+			if (task.tenant != nullptr)
+			{
+				finishTenantTask(task.tenant);
+			}
+		}
+	}
+
+	//ȡһ񣬻ٶȡŵself->batchУ߳Ҫ˳ʱfalse
+	template<typename TimePoint>
+	bool takeTask(int threadid, const TimePoint& lastTime, WorkerState* self, QueuedTask& task, int64_t avgTaskNs)
+	{
+		if constexpr (QueuePolicy::isLockFree)
+		{
+			return takeTaskLockFree(threadid, lastTime, task);
+		}
+		else
+		{
+			return takeTaskLocked(threadid, lastTime, self, task, avgTaskNs);
+		}
+	}
+
+	//һȡٸƽʱʱһһȡ֤ӳٺ͹ƽ
+	//ܶʱгƽָ̣߳TASK_BATCH_MAX_SIZE÷taskQueMtx_
+	size_t batchSize(int64_t avgTaskNs) const
+	{
+		if (avgTaskNs > TASK_BATCH_SHORT_TASK_NS)
+		{
+			return 1;
+		}
+		size_t threads = std::max(curThreadSize_.load(), 1);
+		return std::max((size_t)1, std::min((size_t)taskSize_ / threads, TASK_BATCH_MAX_SIZE));
+	}
+
+	template<typename TimePoint>
+	bool takeTaskLocked(int threadid, const TimePoint& lastTime, WorkerState* self, QueuedTask& task, int64_t avgTaskNs)
+	{
+		//Ȼȡ
+		std::unique_lock<std::mutex> lock(taskQueMtx_);
+		std::cout << "tid:" << std::this_thread::get_id() << "Իȡ..." << std::endl;
+		//cachedģʽ£пѾ˺̡ܶ߳
+		//ǿʱ䳬60sӦðѶ߳̽յ
+		//initThreadSize_߳Ҫл
+		//ǰʱ - һִ߳ʱ > 60s
+		// + ˫ж 
+		Clock::time_point stealAt; //̵߳ķ͵ߵʱ䣬ʱҪ
+		while (!popTask(task, stealAt))
+		{
+			//̳߳Ҫ߳Դ
+			if (!isPoolRunning_) {
+				unregisterWorker();
+				threads_.erase(threadid);
+				std::cout << "threadid:" << std::this_thread::get_id() << "exit!" << std::endl;
+				exitCond_.notify_all();
+				return false;
+			}
+			if (reclaimIfIdle(threadid, lastTime))
+			{
+				return false;
+			}
+			//cachedģʽȴ1sл
+			Clock::time_point wakeAt = stealAt;
+			if (isCachedMode())
+			{
+				wakeAt = std::min(wakeAt, Clock::now() + std::chrono::seconds(1));
+			}
+			self->isWaiting = true;
+			if constexpr (WaitPolicy::isSpin)
+			{
+				//ȴʱʱworkSeq_
+				uint64_t seen = workSeq_;
+				lock.unlock();
+				spinUntil([&]()->bool { return workSeq_ != seen || !isPoolRunning_; }, wakeAt);
+				lock.lock();
+			}
+			else if (wakeAt == Clock::time_point::max())
+			{
+				//ȴŽ
+				self->wakeup.wait(lock);
+			}
+			else
+			{
+				self->wakeup.wait_until(lock, wakeAt);
+			}
+			self->isWaiting = false;
+		}
+
+		if (tracksIdleThreads())
+		{
+			idleThreadSize_--; //̼߳1
+		}
+		std::cout << "tid:" << std::this_thread::get_id() << "ȡɹ..." << std::endl;
+		//ٶȡһŵԼbatchУڵִǰж
+		//ִڼ߳̿˿Դbatch͵һῨס
+		//ֻͨк⻧ȡõָ߳
+		size_t count = batchSize(avgTaskNs);
+		if (count > 1 && hasSharedTask())
+		{
+			std::lock_guard<std::mutex> batchLock(self->batchMtx);
+			for (size_t i = 1; i < count && hasSharedTask(); i++)
+			{
+				self->batch.emplace_back(popNextTask());
 				taskSize_--;
+				batchedTaskSize_++;
+			}
+		}
+
+		if (admissionMode_ == AdmissionMode::ADMIT_CODEL)
+		{
+			//ӵŶʱ
+			updateOverloadState(task, Clock::now());
+		}
+
+		//ʣ񣬼ִ֪ͨ߳
+		//ֻʣõʱһ߳̾͹ˣȵ͵ʱ
+		if (hasSharedTask() || batchedTaskSize_ > 0)
+		{
+			wakeWorkers();
+		}
+		else if (localTaskSize_ > 0)
+		{
+			wakeWorker(nullptr);
+		}
+
+		//ȡ֪ͨ,
+		notFull_.notify_all();
+		return true;
+	}
+
+	template<typename TimePoint>
+	bool takeTaskLockFree(int threadid, const TimePoint& lastTime, QueuedTask& task)
+	{
+		for (;;)
+		{
+			if (taskQue_.tryPop(task))
+			{
+				if (tracksIdleThreads())
+				{
+					idleThreadSize_--;
+					taskSize_--;
+				}
+				return true;
+			}
+
+			std::unique_lock<std::mutex> lock(taskQueMtx_, std::defer_lock);
+			if (!isPoolRunning_ || isCachedMode())
+			{
+				lock.lock();
+				if (!isPoolRunning_ && taskQue_.empty())
+				{
+					threads_.erase(threadid);
+					exitCond_.notify_all();
+					return false;
+				}
+				if (reclaimIfIdle(threadid, lastTime))
+				{
+					return false;
+				}
+			}
 
-				//ʣ񣬼ִ֪ͨ߳
-				if (taskQue_.size() > 0)
+			if constexpr (WaitPolicy::isSpin)
+			{
+				if (lock.owns_lock())
+				{
+					lock.unlock();
+				}
+				spinUntil([&]()->bool { return !taskQue_.empty() || !isPoolRunning_; });
+			}
+			else
+			{
+				if (!lock.owns_lock())
 				{
-					notEmpty_.notify_all();
+					lock.lock();
 				}
+				//afterLockFreePushеդ
+				sleepers_.fetch_add(1);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				notEmpty_.wait_for(lock, std::chrono::seconds(1),
+					[&]()->bool { return !taskQue_.empty() || !isPoolRunning_; });
+				sleepers_.fetch_sub(1);
+			}
+		}
+	}
 
-				//ȡ֪ͨ,
-				notFull_.notify_all();
+	//cachedģʽ¿гTHREAD_MAX_IDLE_TIME߳ڳʼֵʱյǰ߳
+	//÷taskQueMtx_
+	template<typename TimePoint>
+	bool reclaimIfIdle(int threadid, const TimePoint& lastTime)
+	{
+		if (!isCachedMode())
+		{
+			return false;
+		}
+		auto now = std::chrono::high_resolution_clock().now();
+		auto dur = std::chrono::duration_cast<std::chrono::seconds>(now - lastTime);
+		if (dur.count() >= THREAD_MAX_IDLE_TIME
+			&& curThreadSize_ > initThreadSize_)
+		{
+			//ʼյǰ߳
+			//1.¼߳رб仯
 
-			}// ͷŵ
+			//2.̶߳߳бɾ
+			if constexpr (!QueuePolicy::isLockFree)
+			{
+				unregisterWorker();
+			}
+			threads_.erase(threadid);
+			curThreadSize_--;
+			idleThreadSize_--;
+			std::cout << "threadid:" << std::this_thread::get_id() << "exit!" << std::endl;
+			return true;
+		}
+		return false;
+	}
 
-			//ǰ̸ִ߳
-			if (task != nullptr)
+	//ȴ㣬ȴuntilҲ1sõ÷лл
+	template<typename Pred>
+	void spinUntil(Pred pred, Clock::time_point until = Clock::time_point::max())
+	{
+		auto end = std::min(until, Clock::now() + std::chrono::seconds(1));
+		for (int i = 0; !pred(); i++)
+		{
+			if (i < SPIN_WAIT_ROUNDS)
 			{
-				//task->run();//ִ񣻰ִķֵͨsetValResult
-				task(); //using Task = std::function<void()> packaged_taskõ
+				SpinWait::pause();
+				continue;
+			}
+			std::this_thread::yield();
+			if (i % SPIN_WAIT_ROUNDS == 0 && Clock::now() >= end)
+			{
+				return;
 			}
-			idleThreadSize_++;
-			lastTime = std::chrono::high_resolution_clock().now(); //ִ߳ʱ
 		}
 	}
+
 	//pool״̬
 	bool checkRunningState() const
 	{
@@ -309,21 +2465,71 @@ private:
 	std::atomic_int curThreadSize_;//¼ǰ߳
 	int threadSizeThreshHold_; //ֵ߳
 
-	using Task = std::function<void()>;
-	std::queue<Task> taskQue_; //
-	std::atomic_int taskSize_; //
+	typename QueuePolicy::template Queue<QueuedTask> taskQue_; //
+	std::atomic_int taskSize_; //ִе⻧
+	std::unordered_map<TenantId, std::unique_ptr<TenantState>> tenants_; //⻧ɾ
+	std::deque<TenantState*> activeTenants_; //ҿִе⻧ת˳
+	TenantState defaultTenant_; //⻧ʱͨΪĬ⻧ת
+	std::vector<std::unique_ptr<WorkerState>> workers_; //߳±꣬߳˳̸߳
+	std::vector<std::deque<QueuedTask>> groupQues_; //ÿһ
+	size_t localTaskSize_ = 0; //̺߳ͻе
+	std::atomic<size_t> batchedTaskSize_{ 0 }; //й߳batchлûִеtaskSize_
+	std::atomic<uint64_t> workSeq_{ 0 }; //ÿµĿִʱ1ȴ߳̾ݴ
 	int taskQueMaxThreshHold_; //ֵ
 
 	std::mutex taskQueMtx_;//֤̰߳ȫ
 	std::condition_variable notFull_; //ʾв
 	std::condition_variable notEmpty_;//ʾв
 	std::condition_variable exitCond_;//ȴ߳Դȫ
+	std::atomic_int sleepers_{ 0 };//notEmpty_ϵ߳
 
 	PoolMode poolMode_; // ǰ̳߳صĹģʽ
 	std::atomic_bool isPoolRunning_; //ʾ̳߳صĹ״̬
 
+	AdmissionMode admissionMode_; //׼Ʒʽ
+	Clock::duration codelTarget_; //ŶʱĿֵ
+	Clock::duration codelInterval_; //жصʱ䴰
+	Clock::time_point firstAboveTime_; //Ŷʱ䳬󣬵ʱԳΪ
+	bool isOverloaded_; //Ƿڹ״̬taskQueMtx_
+
+	SharedShard sharedShards_[SHARED_TASK_SHARDS]; //submitShared;
+	std::atomic<Clock::duration> sharedResultTTL_{ Clock::duration::zero() }; //ʱ
+
+	std::atomic<TraceRecorder*> recorder_{ nullptr }; //ڽеĹ켣¼ûм¼ʱΪnullptr
+	std::vector<std::unique_ptr<TraceRecorder>> recorders_; //ܻ߳̿žɵָ룬̳߳ʱͷ
+	std::mutex recorderMtx_;
+
+	ThreadBudget* budget_ = nullptr; //߳Ԥ㣬ûмʱΪnullptr
+	ThreadBudget::Member* budgetMember_ = nullptr;
+
+	std::atomic<uint64_t> hedgedCalls_{ 0 }; //submitHedgedύ
+	std::atomic<uint64_t> hedgesLaunched_{ 0 }; //ύĶԳִ
+	std::atomic_int hedgeBudgetPercent_{ HEDGE_BUDGET_PERCENT };
+	std::unordered_map<const char*, HedgeHistory> hedgeHistory_; // -> ִʱ
+	std::mutex hedgeMtx_;
+	std::multimap<Clock::time_point, std::function<void()>> timers_; //ʱ -> ص
+	std::mutex timerMtx_;
+	std::condition_variable timerCond_;
+	std::thread timerThread_;
+	bool isTimerStopped_ = false;
+
+#ifdef __linux__
+	std::unordered_map<int, std::shared_ptr<IoHandler>> ioHandlers_; //fd -> ص
+	std::mutex ioMtx_; //ioHandlers_reactorfd
+	int epollFd_ = -1;
+	int wakeFd_ = -1; //eventfdreactor߳
+	std::thread reactorThread_;
+	std::atomic_bool isReactorRunning_{ false };
+#endif
+
 };
 
+//ԭThreadPoolΪһ£ +  + ʱsetMode + std::function
+using ThreadPool = BasicThreadPool<>;
+
+//̶߳ +  + ȴ + öѷ洢
+using FixedSpinThreadPool = BasicThreadPool<LockFreeQueue, SpinWait, FixedGrowth, InlineTask>;
+
 
 #endif
 
@@ -0,0 +1,307 @@
+#ifndef THREADPOOL_ALGORITHMS_H
+#define THREADPOOL_ALGORITHMS_H
+
+#include <vector>
+#include <future>
+#include <atomic>
+#include <algorithm>
+#include <numeric>
+#include <functional>
+#include <iterator>
+#include <exception>
+
+#include "threadpool.h"
+
+/*
+ThreadPoolĲ㷨̳߳еḶ́߳ⴴ߳
+BasicThreadPoolʵʹ
+example:
+ThreadPool pool;
+pool.start(4);
+std::vector<int> vec(10000000);
+parallelSort(pool, vec.begin(), vec.end());
+auto it = parallelFindIf(pool, vec.begin(), vec.end(), [](int x) { return x > 100; });
+
+ע⣺̻߳ȴзֿɣҪ̳߳صã
+fixedģʽй̶߳ڵȴʱ
+*/
+
+const size_t ALGO_MIN_CHUNK_SIZE = 4096; //ÿֿԪظ̫СĻȿȼ㻹
+const size_t ALGO_CHUNKS_PER_THREAD = 4; //ÿ̷ֵ߳ĿһЩظ
+const size_t ALGO_FIND_CHECK_STEP = 1024; //findIfÿôԪؼһǷѾҵ
+
+//Ԫظֿ߳
+template<typename Pool>
+size_t algoChunkCount(Pool& pool, size_t n)
+{
+	size_t threads = std::max(pool.getThreadSize(), 1);
+	size_t chunks = std::min(threads * ALGO_CHUNKS_PER_THREAD, (n + ALGO_MIN_CHUNK_SIZE - 1) / ALGO_MIN_CHUNK_SIZE);
+	return std::max(chunks, (size_t)1);
+}
+
+//[0, n)ֳchunksύ̳߳أfn(chunkIndex, begin, end)ȴп
+//ܾĿɵ߳ԼִУ쳣ʱȫ׳һ쳣
+template<typename Pool, typename Fn>
+void algoForChunks(Pool& pool, size_t n, size_t chunks, Fn fn)
+{
+	//ÿ쳣packaged_taskfuture
+	std::vector<std::packaged_task<void()>> tasks;
+	std::vector<std::future<void>> results;
+	tasks.reserve(chunks);
+	results.reserve(chunks);
+	for (size_t i = 0; i < chunks; i++)
+	{
+		size_t begin = n * i / chunks;
+		size_t end = n * (i + 1) / chunks;
+		tasks.emplace_back([&fn, i, begin, end]() { fn(i, begin, end); });
+		results.emplace_back(tasks[i].get_future());
+		std::packaged_task<void()>& task = tasks[i];
+		if (!pool.trySubmit([&task]() { task(); }))
+		{
+			task();
+		}
+	}
+
+	std::exception_ptr error;
+	for (size_t i = 0; i < chunks; i++)
+	{
+		try
+		{
+			results[i].get();
+		}
+		catch (...)
+		{
+			if (!error)
+			{
+				error = std::current_exception();
+			}
+		}
+	}
+	if (error)
+	{
+		std::rethrow_exception(error);
+	}
+}
+
+//鲢·ab鲢ǰdԪУжٸaֲ
+//ȵԪaǰstd::mergeһ
+template<typename It1, typename It2, typename Compare>
+size_t algoMergeSplit(It1 a, size_t la, It2 b, size_t lb, size_t d, Compare& comp)
+{
+	size_t lo = d > lb ? d - lb : 0;
+	size_t hi = std::min(d, la);
+	while (lo < hi)
+	{
+		size_t mid = (lo + hi) / 2;
+		if (comp(*(b + (d - mid - 1)), *(a + mid)))
+		{
+			hi = mid;
+		}
+		else
+		{
+			lo = mid + 1;
+		}
+	}
+	return lo;
+}
+
+//ȸ鲢鲢
+//ÿһְй鲢λгɴԼchunksΣù鲢·ҵÿе㣬βй鲢
+//ÿһ֣ϳһһ֣̣߳鲢ԭһͬСĻ֮ؽ
+//ԪҪĬϹ
+template<typename Pool, typename RandomIt, typename Compare = std::less<>>
+void parallelSort(Pool& pool, RandomIt first, RandomIt last, Compare comp = Compare())
+{
+	using T = typename std::iterator_traits<RandomIt>::value_type;
+	size_t n = std::distance(first, last);
+	size_t chunks = algoChunkCount(pool, n);
+	if (chunks == 1)
+	{
+		std::sort(first, last, comp);
+		return;
+	}
+
+	//¼ÿı߽磬鲢ʱϳһ
+	std::vector<size_t> bounds(chunks + 1);
+	for (size_t i = 0; i <= chunks; i++)
+	{
+		bounds[i] = n * i / chunks;
+	}
+	algoForChunks(pool, n, chunks, [&](size_t, size_t begin, size_t end) {
+		std::sort(first + begin, first + end, comp);
+	});
+
+	//һι鲢run͵run + 1ϲλ[begin, end)Ĳ֣
+	//[fromA, toA)ⲿڵrunеķΧ
+	struct MergeJob
+	{
+		size_t run;
+		size_t begin;
+		size_t end;
+		size_t fromA;
+		size_t toA;
+	};
+	std::vector<MergeJob> jobs;
+	std::vector<T> buffer(n);
+	bool isInBuffer = false; //ǰbufferлԭ
+
+	while (bounds.size() > 2)
+	{
+		size_t runs = bounds.size() - 1;
+		jobs.clear();
+		for (size_t r = 0; r < runs; r += 2)
+		{
+			//ΪʱһûԣҲҪᵽһ
+			size_t len = bounds[std::min(r + 2, runs)] - bounds[r];
+			size_t pieces = std::max((size_t)1, len * chunks / n);
+			for (size_t p = 0; p < pieces; p++)
+			{
+				jobs.push_back(MergeJob{ r, len * p / pieces, len * (p + 1) / pieces, 0, 0 });
+			}
+		}
+
+		//зֶеλãٿʼ鲢ֲҿֶܶѾߵԪ
+		auto mergeRound = [&](auto src, auto dst) {
+			algoForChunks(pool, jobs.size(), jobs.size(), [&](size_t k, size_t, size_t) {
+				MergeJob& job = jobs[k];
+				size_t lo = bounds[job.run];
+				size_t mid = bounds[std::min(job.run + 1, runs)];
+				size_t hi = bounds[std::min(job.run + 2, runs)];
+				job.fromA = algoMergeSplit(src + lo, mid - lo, src + mid, hi - mid, job.begin, comp);
+				job.toA = algoMergeSplit(src + lo, mid - lo, src + mid, hi - mid, job.end, comp);
+			});
+			algoForChunks(pool, jobs.size(), jobs.size(), [&](size_t k, size_t, size_t) {
+				const MergeJob& job = jobs[k];
+				auto a = src + bounds[job.run];
+				auto b = src + bounds[std::min(job.run + 1, runs)];
+				std::merge(std::make_move_iterator(a + job.fromA), std::make_move_iterator(a + job.toA),
+					std::make_move_iterator(b + (job.begin - job.fromA)), std::make_move_iterator(b + (job.end - job.toA)),
+					dst + (bounds[job.run] + job.begin), comp);
+			});
+		};
+		if (isInBuffer)
+		{
+			mergeRound(buffer.begin(), first);
+		}
+		else
+		{
+			mergeRound(first, buffer.begin());
+		}
+		isInBuffer = !isInBuffer;
+
+		std::vector<size_t> merged;
+		for (size_t i = 0; i < bounds.size(); i += 2)
+		{
+			merged.push_back(bounds[i]);
+		}
+		if (merged.back() != n)
+		{
+			merged.push_back(n);
+		}
+		bounds.swap(merged);
+	}
+
+	if (isInBuffer)
+	{
+		algoForChunks(pool, n, chunks, [&](size_t, size_t begin, size_t end) {
+			std::move(buffer.begin() + begin, buffer.begin() + end, first + begin);
+		});
+	}
+}
+
+//transformd_firstʼҪ㹻
+template<typename Pool, typename RandomIt, typename OutputIt, typename UnaryOp>
+OutputIt parallelTransform(Pool& pool, RandomIt first, RandomIt last, OutputIt d_first, UnaryOp op)
+{
+	size_t n = std::distance(first, last);
+	algoForChunks(pool, n, algoChunkCount(pool, n), [&](size_t, size_t begin, size_t end) {
+		std::transform(first + begin, first + end, d_first + begin, op);
+	});
+	return d_first + n;
+}
+
+//ǰ׺ͣopҪ
+//1.鲢ǰ׺  2.мÿƫ  3.һ鲢мƫ
+template<typename Pool, typename RandomIt, typename OutputIt, typename BinaryOp = std::plus<>>
+OutputIt parallelInclusiveScan(Pool& pool, RandomIt first, RandomIt last, OutputIt d_first, BinaryOp op = BinaryOp())
+{
+	using T = typename std::iterator_traits<RandomIt>::value_type;
+	size_t n = std::distance(first, last);
+	if (n == 0)
+	{
+		return d_first;
+	}
+	size_t chunks = algoChunkCount(pool, n);
+
+	algoForChunks(pool, n, chunks, [&](size_t, size_t begin, size_t end) {
+		std::partial_sum(first + begin, first + end, d_first + begin, op);
+	});
+
+	//offsets[i]Ϊi֮ǰԪصĺ
+	std::vector<T> offsets(chunks);
+	for (size_t i = 1; i < chunks; i++)
+	{
+		T last = *(d_first + (n * i / chunks - 1));
+		offsets[i] = (i == 1) ? last : op(offsets[i - 1], last);
+	}
+
+	algoForChunks(pool, n, chunks, [&](size_t i, size_t begin, size_t end) {
+		if (i == 0)
+		{
+			return;
+		}
+		for (size_t k = begin; k < end; k++)
+		{
+			*(d_first + k) = op(offsets[i], *(d_first + k));
+		}
+	});
+	return d_first + n;
+}
+
+//count_if
+template<typename Pool, typename RandomIt, typename UnaryPred>
+size_t parallelCountIf(Pool& pool, RandomIt first, RandomIt last, UnaryPred pred)
+{
+	size_t n = std::distance(first, last);
+	size_t chunks = algoChunkCount(pool, n);
+	std::vector<size_t> counts(chunks);
+	algoForChunks(pool, n, chunks, [&](size_t i, size_t begin, size_t end) {
+		counts[i] = std::count_if(first + begin, first + end, pred);
+	});
+
+	size_t total = 0;
+	for (size_t count : counts)
+	{
+		total += count;
+	}
+	return total;
+}
+
+//find_ifصһԪأstd::find_ifһ
+//ĳһҵλĿ鲻ټңûʼִеĿֱӷ
+template<typename Pool, typename RandomIt, typename UnaryPred>
+RandomIt parallelFindIf(Pool& pool, RandomIt first, RandomIt last, UnaryPred pred)
+{
+	size_t n = std::distance(first, last);
+	std::atomic<size_t> found(n); //ĿǰҵС±
+	algoForChunks(pool, n, algoChunkCount(pool, n), [&](size_t, size_t begin, size_t end) {
+		for (size_t k = begin; k < end; k++)
+		{
+			if ((k - begin) % ALGO_FIND_CHECK_STEP == 0 && k >= found.load(std::memory_order_relaxed))
+			{
+				return;
+			}
+			if (pred(*(first + k)))
+			{
+				size_t cur = found.load();
+				while (k < cur && !found.compare_exchange_weak(cur, k))
+				{
+				}
+				return;
+			}
+		}
+	});
+	return first + found.load();
+}
+
+#endif
@@ -0,0 +1,270 @@
+#ifndef THREADPOOL_FILESCAN_H
+#define THREADPOOL_FILESCAN_H
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <optional>
+#include <utility>
+#include <stdexcept>
+#include <system_error>
+#include <cerrno>
+#include <cstdint>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "threadpool_algorithms.h"
+
+/*
+̳߳زɨļļmmapӳ䣬ֱ߳Ӷӳڴ棬
+example:
+ThreadPool pool;
+pool.start(8);
+//ͳưERROR
+size_t errors = parallelScanFile(pool, "app.log", (size_t)0,
+	[](std::string_view chunk)->size_t {
+		size_t count = 0;
+		forEachRecord(chunk, "\n", [&](std::string_view line) { count += line.find("ERROR") != std::string_view::npos; });
+		return count;
+	},
+	[](size_t acc, size_t part) { return acc + part; });
+
+ļڣFILESCAN_WINDOW_SIZEӳ䣬ͬһʱӳ䵱ǰһڣļСڴƣ
+ںͷֿı߽綼뵽ָ֮ÿֻֿļ¼һ¼ûзָ
+ǰʱԤһڣ߳̿ʼֿǰٶԼķֿһԤ
+ֻ֧POSIXϵͳ̻߳ȴҪ̳߳ص
+*/
+
+const size_t FILESCAN_CHUNK_SIZE = 4 << 20; //ÿֿĴСʵʻӳһָ
+const size_t FILESCAN_WINDOW_SIZE = 256 << 20; //ÿӳĴСһ¼ȴڻʱԶ
+
+//ָȡchunkеÿ¼¼ָ
+template<typename Fn>
+void forEachRecord(std::string_view chunk, std::string_view delimiter, Fn fn)
+{
+	size_t pos = 0;
+	while (pos < chunk.size())
+	{
+		size_t end = chunk.find(delimiter, pos);
+		if (end == std::string_view::npos)
+		{
+			fn(chunk.substr(pos));
+			return;
+		}
+		fn(chunk.substr(pos, end - pos));
+		pos = end + delimiter.size();
+	}
+}
+
+//ļӳһڣʱӳ
+class ScanWindow
+{
+public:
+	ScanWindow() = default;
+
+	~ScanWindow()
+	{
+		reset();
+	}
+
+	ScanWindow(ScanWindow&& other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	ScanWindow& operator=(ScanWindow&& other) noexcept
+	{
+		if (this != &other)
+		{
+			reset();
+			std::swap(mapAddr_, other.mapAddr_);
+			std::swap(mapLen_, other.mapLen_);
+			data = other.data;
+			end = other.end;
+		}
+		return *this;
+	}
+
+	void reset(void* addr = nullptr, size_t len = 0)
+	{
+		if (mapAddr_ != nullptr)
+		{
+			::munmap(mapAddr_, mapLen_);
+		}
+		mapAddr_ = addr;
+		mapLen_ = len;
+	}
+
+	std::string_view data; //е¼
+	size_t end = 0; //dataļеƫƣҲһڵ
+
+private:
+	void* mapAddr_ = nullptr;
+	size_t mapLen_ = 0;
+};
+
+//Ԥһӳڴ棬ʼַҪҳ
+inline void scanAdvise(std::string_view range, int advice)
+{
+	static const uintptr_t pageSize = (uintptr_t)::sysconf(_SC_PAGESIZE);
+	uintptr_t begin = (uintptr_t)range.data() / pageSize * pageSize;
+	uintptr_t end = (uintptr_t)range.data() + range.size();
+	if (end > begin)
+	{
+		::madvise((void*)begin, end - begin, advice);
+	}
+}
+
+//ֻʽ򿪵ļʱر
+class ScanFile
+{
+public:
+	explicit ScanFile(const std::string& path)
+	{
+		fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		struct stat st;
+		if (fd_ < 0 || ::fstat(fd_, &st) != 0)
+		{
+			int err = errno;
+			if (fd_ >= 0)
+			{
+				::close(fd_);
+			}
+			throw std::system_error(err, std::generic_category(), "parallelScanFile: open " + path);
+		}
+		size_ = (size_t)st.st_size;
+	}
+
+	~ScanFile()
+	{
+		::close(fd_);
+	}
+
+	size_t size() const
+	{
+		return size_;
+	}
+
+	//beginʼӳһڣڽβ뵽һָ֮
+	void map(size_t begin, std::string_view delimiter, ScanWindow& window) const
+	{
+		static const size_t pageSize = (size_t)::sysconf(_SC_PAGESIZE);
+		size_t mapBegin = begin / pageSize * pageSize; //mmapƫƱ밴ҳ
+		for (size_t windowSize = FILESCAN_WINDOW_SIZE;; windowSize *= 2)
+		{
+			size_t mapLen = std::min(size_ - mapBegin, begin - mapBegin + windowSize);
+			void* addr = ::mmap(nullptr, mapLen, PROT_READ, MAP_PRIVATE, fd_, (off_t)mapBegin);
+			if (addr == MAP_FAILED)
+			{
+				throw std::system_error(errno, std::generic_category(), "parallelScanFile: mmap");
+			}
+			window.reset(addr, mapLen);
+			std::string_view view((const char*)addr + (begin - mapBegin), mapLen - (begin - mapBegin));
+			::madvise(addr, mapLen, MADV_SEQUENTIAL);
+
+			if (mapBegin + mapLen == size_)
+			{
+				window.data = view;
+				window.end = size_;
+				return;
+			}
+			size_t last = view.rfind(delimiter);
+			if (last != std::string_view::npos)
+			{
+				window.data = view.substr(0, last + delimiter.size());
+				window.end = begin + window.data.size();
+				return;
+			}
+			//һ¼ȴڻ󴰿ӳ
+		}
+	}
+
+	ScanFile(const ScanFile&) = delete;
+	ScanFile& operator=(const ScanFile&) = delete;
+
+private:
+	int fd_ = -1;
+	size_t size_ = 0;
+};
+
+//ѴгɴԼchunkSizeСķֿ飬ÿβ뵽ָ֮
+inline std::vector<std::string_view> scanSplitChunks(std::string_view data, std::string_view delimiter, size_t chunkSize)
+{
+	std::vector<std::string_view> chunks;
+	size_t pos = 0;
+	while (pos < data.size())
+	{
+		size_t end = data.size();
+		if (data.size() - pos > chunkSize)
+		{
+			size_t found = data.find(delimiter, pos + chunkSize - 1);
+			if (found != std::string_view::npos)
+			{
+				end = found + delimiter.size();
+			}
+		}
+		chunks.push_back(data.substr(pos, end - pos));
+		pos = end;
+	}
+	return chunks;
+}
+
+//ɨļmapFn(chunk)һֿ鷵زֽreduceFn(acc, part)ֿļе˳ϲ
+//ֿļ¼ͼ¼֮ķָֿ鱻ܾʱɵִ߳У
+//򿪻ӳļʧ׳std::system_errormapFn׳쳣ڵǰڴ׳
+template<typename Pool, typename R, typename MapFn, typename ReduceFn>
+R parallelScanFile(Pool& pool, const std::string& path, R init, MapFn mapFn, ReduceFn reduceFn,
+	std::string_view delimiter = "\n", size_t chunkSize = FILESCAN_CHUNK_SIZE)
+{
+	if (delimiter.empty())
+	{
+		throw std::invalid_argument("parallelScanFile: empty delimiter");
+	}
+	ScanFile file(path);
+	R result = std::move(init);
+	if (file.size() == 0)
+	{
+		return result;
+	}
+	chunkSize = std::max(chunkSize, (size_t)1);
+
+	ScanWindow cur;
+	ScanWindow next;
+	file.map(0, delimiter, cur);
+	for (;;)
+	{
+		//ǰӳһڲںԤ͵ǰڵĴص
+		bool hasNext = cur.end < file.size();
+		if (hasNext)
+		{
+			file.map(cur.end, delimiter, next);
+			scanAdvise(next.data, MADV_WILLNEED);
+		}
+
+		std::vector<std::string_view> chunks = scanSplitChunks(cur.data, delimiter, chunkSize);
+		std::vector<std::optional<R>> parts(chunks.size());
+		algoForChunks(pool, chunks.size(), chunks.size(), [&](size_t i, size_t, size_t) {
+			scanAdvise(chunks[i], MADV_WILLNEED);
+			parts[i].emplace(mapFn(chunks[i]));
+		});
+		for (auto& part : parts)
+		{
+			result = reduceFn(std::move(result), std::move(*part));
+		}
+
+		if (!hasNext)
+		{
+			return result;
+		}
+		cur = std::move(next); //ǰڵӳ
+	}
+}
+
+#endif
+
+#endif
@@ -0,0 +1,234 @@
+#ifndef THREADPOOL_PIPELINE_H
+#define THREADPOOL_PIPELINE_H
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+
+#include "threadpool.h"
+
+/*
+ThreadPoolĶ༶ˮ
+example:
+struct Record { std::string line; Row row; std::string packed; };
+ThreadPool pool;
+pool.start(4);
+Pipeline<Record> pipeline(pool, 16);//16ԪͬʱˮУڴռ
+pipeline.addStage(StageMode::STAGE_PARALLEL, parse)
+	.addStage(StageMode::STAGE_PARALLEL, compress)
+	.addStage(StageMode::STAGE_SERIAL_IN_ORDER, write);//˳д
+pipeline.run([&](Record& rec)->bool { return std::getline(in, rec.line) ? true : false; });
+
+һԪڹ߳Ͼһĸֲֻԣ
+мʱûֵݴǰ߳ȥ
+ǰһԪһٰύ̳߳
+run()ȴԪش꣬Ҫ̳߳ص
+*/
+
+//ˮÿһִзʽ
+enum class StageMode
+{
+	STAGE_PARALLEL,        //Ԫؿͬʱִ
+	STAGE_SERIAL_IN_ORDER, //ͬһʱִֻһԪأҰ˳ִ
+};
+
+template<typename T, typename Pool = ThreadPool>
+class Pipeline
+{
+public:
+	//ÿһԪԭش
+	using StageFunc = std::function<void(T&)>;
+	//ȡһ룬falseʾڵrun߳ϴִ
+	using SourceFunc = std::function<bool(T&)>;
+
+	Pipeline(Pool& pool, size_t maxTokens)
+		:pool_(pool)
+		, maxTokens_(maxTokens > 0 ? maxTokens : 1)
+		, inFlight_(0)
+	{}
+
+	~Pipeline() = default;
+
+	//һ˳ִ
+	Pipeline& addStage(StageMode mode, StageFunc func)
+	{
+		stages_.emplace_back(std::make_unique<Stage>(mode, std::move(func)));
+		return *this;
+	}
+
+	//sourceȡ벢ˮߣֱԪضһ
+	//ĳһ׳쳣ʱԪrun׳һ쳣
+	void run(SourceFunc source)
+	{
+		for (auto& stage : stages_)
+		{
+			stage->nextSeq = 0;
+		}
+		error_ = nullptr;
+
+		for (size_t seq = 0;; seq++)
+		{
+			//ȴеtokenͬʱˮеԪظ
+			{
+				std::unique_lock<std::mutex> lock(mtx_);
+				tokenFree_.wait(lock, [&]()->bool { return inFlight_ < maxTokens_; });
+			}
+
+			auto token = std::make_shared<Token>();
+			token->item = std::make_shared<T>();
+			token->seq = seq;
+			token->failed = false;
+			try
+			{
+				if (!source(*token->item))
+				{
+					break;
+				}
+			}
+			catch (...)
+			{
+				setError(std::current_exception());
+				break;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(mtx_);
+				inFlight_++;
+			}
+			dispatch(token, 0);
+		}
+
+		std::unique_lock<std::mutex> lock(mtx_);
+		tokenFree_.wait(lock, [&]()->bool { return inFlight_ == 0; });
+		if (error_)
+		{
+			std::rethrow_exception(error_);
+		}
+	}
+
+	Pipeline(const Pipeline&) = delete;
+	Pipeline& operator=(const Pipeline&) = delete;
+
+private:
+	//ˮеһԪ
+	struct Token
+	{
+		std::shared_ptr<T> item;
+		size_t seq;  //˳
+		bool failed; //ǰĳһ쳣
+	};
+
+	struct Stage
+	{
+		Stage(StageMode m, StageFunc f)
+			:mode(m)
+			, func(std::move(f))
+			, nextSeq(0)
+		{}
+
+		StageMode mode;
+		StageFunc func;
+		//ֻڴм
+		std::mutex mtx;
+		size_t nextSeq; //һִеԪ
+		std::map<size_t, std::shared_ptr<Token>> pending; //ûֵԪ
+	};
+
+	//Ԫشӵstageʼ̳߳أܾʱɵǰֱִ߳
+	void dispatch(std::shared_ptr<Token> token, size_t stage)
+	{
+		if (!pool_.trySubmit([this, token, stage]() {
+			runFrom(token, stage);
+		}))
+		{
+			runFrom(token, stage);
+		}
+	}
+
+	//ڵǰ߳Ԫĸ
+	void runFrom(std::shared_ptr<Token> token, size_t first)
+	{
+		for (size_t i = first; i < stages_.size(); i++)
+		{
+			Stage& stage = *stages_[i];
+			if (stage.mode == StageMode::STAGE_PARALLEL)
+			{
+				runStage(stage, *token);
+				continue;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(stage.mtx);
+				if (token->seq != stage.nextSeq)
+				{
+					//ûֵݴǰһԪһύ
+					stage.pending.emplace(token->seq, token);
+					return;
+				}
+			}
+			runStage(stage, *token);
+
+			std::shared_ptr<Token> next;
+			{
+				std::lock_guard<std::mutex> lock(stage.mtx);
+				stage.nextSeq++;
+				auto it = stage.pending.find(stage.nextSeq);
+				if (it != stage.pending.end())
+				{
+					next = it->second;
+					stage.pending.erase(it);
+				}
+			}
+			if (next != nullptr)
+			{
+				dispatch(next, i);
+			}
+		}
+
+		//һ黹token
+		std::lock_guard<std::mutex> lock(mtx_);
+		inFlight_--;
+		tokenFree_.notify_all();
+	}
+
+	void runStage(Stage& stage, Token& token)
+	{
+		if (token.failed)
+		{
+			return;
+		}
+		try
+		{
+			stage.func(*token.item);
+		}
+		catch (...)
+		{
+			token.failed = true;
+			setError(std::current_exception());
+		}
+	}
+
+	void setError(std::exception_ptr error)
+	{
+		std::lock_guard<std::mutex> lock(mtx_);
+		if (!error_)
+		{
+			error_ = error;
+		}
+	}
+
+private:
+	Pool& pool_;
+	std::vector<std::unique_ptr<Stage>> stages_; //Stagemutexָ뱣
+	size_t maxTokens_; //ͬʱˮеԪظ
+	size_t inFlight_; //ǰˮеԪظ
+	std::mutex mtx_;
+	std::condition_variable tokenFree_; //token黹
+	std::exception_ptr error_; //һ쳣
+};
+
+#endif
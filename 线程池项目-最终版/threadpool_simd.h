@@ -0,0 +1,923 @@
+#ifndef THREADPOOL_SIMD_H
+#define THREADPOOL_SIMD_H
+
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <utility>
+#include <type_traits>
+#include <cstdint>
+#include <cstddef>
+
+#include "threadpool_algorithms.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define THREADPOOL_SIMD_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+//gcc/clangҪʹø߰汾ָĺָtargetļ԰ָ룻msvcҪ
+#if defined(THREADPOOL_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#define SIMD_TARGET(isa) __attribute__((target(isa)))
+#else
+#define SIMD_TARGET(isa)
+#endif
+
+/*
+ThreadPoolSIMDԼ͡СֱֵͼΪ
+example:
+ThreadPool pool;
+pool.start(8);
+std::vector<int> vec(100000000, 1);
+int64_t sum = parallelSum(pool, vec.data(), vec.size());
+auto range = parallelMinMax(pool, vec.data(), vec.size());
+std::vector<uint64_t> hist = parallelHistogram(pool, vec.data(), vec.size(), 0, 100, 10);
+
+int32_tint64_tfloatdoubleSSE2/AVX2/AVX-512ʵ֣ʱCPUֵָ֧ѡñ
+ֿ߽뵽SIMD_CHUNK_ALIGNֽڣÿ̴߳ݴӻпͷʼ
+͡64λۼӣdoubleۼӣSIMDͱĸΪ˳ͬ΢С𣻲֧NaN
+*/
+
+const size_t SIMD_CHUNK_ALIGN = 64; //ֽֿ߽AVX-512һδ64ֽڣҲǻдС
+
+//SIMDָ𣬴ӵ͵
+enum class SimdLevel
+{
+	SIMD_SCALAR,
+	SIMD_SSE2,
+	SIMD_AVX2,
+	SIMD_AVX512,
+};
+
+//͡Ľ
+template<typename T>
+using SimdSumType = std::conditional_t<std::is_floating_point<T>::value, double,
+	std::conditional_t<std::is_signed<T>::value, int64_t, uint64_t>>;
+
+//CPUͲϵͳֵ֧߼
+inline SimdLevel detectSimdLevel()
+{
+#if defined(THREADPOOL_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f"))
+	{
+		return SimdLevel::SIMD_AVX512;
+	}
+	if (__builtin_cpu_supports("avx2"))
+	{
+		return SimdLevel::SIMD_AVX2;
+	}
+	if (__builtin_cpu_supports("sse2"))
+	{
+		return SimdLevel::SIMD_SSE2;
+	}
+	return SimdLevel::SIMD_SCALAR;
+#elif defined(THREADPOOL_SIMD_X86) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+	__cpuid(info, 1);
+	bool hasSse2 = (info[3] >> 26) & 1;
+	bool hasAvx = ((info[2] >> 27) & 1) && ((info[2] >> 28) & 1); //OSXSAVE + AVX
+	unsigned long long xcr0 = hasAvx ? _xgetbv(0) : 0;
+	if (maxLeaf >= 7 && (xcr0 & 0x6) == 0x6)
+	{
+		__cpuidex(info, 7, 0);
+		//ϵͳҪAVX-512ļĴ״̬
+		if (((info[1] >> 16) & 1) && (xcr0 & 0xE6) == 0xE6)
+		{
+			return SimdLevel::SIMD_AVX512;
+		}
+		if ((info[1] >> 5) & 1)
+		{
+			return SimdLevel::SIMD_AVX2;
+		}
+	}
+	return hasSse2 ? SimdLevel::SIMD_SSE2 : SimdLevel::SIMD_SCALAR;
+#else
+	return SimdLevel::SIMD_SCALAR;
+#endif
+}
+
+//ʹõ߼ڶԱȲͬʵֵܣĬϲ
+inline std::atomic<SimdLevel>& simdLevelLimit()
+{
+	static std::atomic<SimdLevel> limit(SimdLevel::SIMD_AVX512);
+	return limit;
+}
+
+inline void setMaxSimdLevel(SimdLevel level)
+{
+	simdLevelLimit() = level;
+}
+
+//ʵʹõļ
+inline SimdLevel simdLevel()
+{
+	static const SimdLevel detected = detectSimdLevel();
+	return std::min(detected, simdLevelLimit().load(std::memory_order_relaxed));
+}
+
+//----------------------------------------ʵ----------------------------------------
+
+template<typename T>
+SimdSumType<T> simdSumScalar(const T* p, size_t n)
+{
+	SimdSumType<T> sum = 0;
+	for (size_t i = 0; i < n; i++)
+	{
+		sum += p[i];
+	}
+	return sum;
+}
+
+template<typename T>
+std::pair<T, T> simdMinMaxScalar(const T* p, size_t n)
+{
+	T mn = std::numeric_limits<T>::max();
+	T mx = std::numeric_limits<T>::lowest();
+	for (size_t i = 0; i < n; i++)
+	{
+		mn = std::min(mn, p[i]);
+		mx = std::max(mx, p[i]);
+	}
+	return { mn, mx };
+}
+
+template<typename T>
+SimdSumType<T> simdDotScalar(const T* a, const T* b, size_t n)
+{
+	SimdSumType<T> sum = 0;
+	for (size_t i = 0; i < n; i++)
+	{
+		sum += (SimdSumType<T>)a[i] * (SimdSumType<T>)b[i];
+	}
+	return sum;
+}
+
+//ֱͼķͰ[lo, hi)ֳbinsͰ
+struct HistogramRange
+{
+	double lo;
+	double hi;
+	double scale; //bins / (hi - lo)
+	size_t bins;
+};
+
+//counts4 * binsԪأԪۼӵ4ݼдͬһͰʱ
+template<typename T>
+void simdHistogramScalar(const T* p, size_t n, const HistogramRange& range, uint64_t* counts)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		double x = (double)p[i];
+		if (x >= range.lo && x < range.hi)
+		{
+			size_t bin = std::min((size_t)((x - range.lo) * range.scale), range.bins - 1);
+			counts[(i & 3) * range.bins + bin]++;
+		}
+	}
+}
+
+#ifdef THREADPOOL_SIMD_X86
+
+//----------------------------------------SSE2----------------------------------------
+
+SIMD_TARGET("sse2") inline int64_t simdSumSse2(const int32_t* p, size_t n)
+{
+	__m128i acc = _mm_setzero_si128();
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		//SSE2ûзչָƵõ32λ
+		__m128i x = _mm_loadu_si128((const __m128i*)(p + i));
+		__m128i sign = _mm_srai_epi32(x, 31);
+		acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(x, sign));
+		acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(x, sign));
+	}
+	alignas(16) int64_t lanes[2];
+	_mm_store_si128((__m128i*)lanes, acc);
+	return lanes[0] + lanes[1] + simdSumScalar(p + i, n - i);
+}
+
+SIMD_TARGET("sse2") inline int64_t simdSumSse2(const int64_t* p, size_t n)
+{
+	__m128i acc = _mm_setzero_si128();
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2)
+	{
+		acc = _mm_add_epi64(acc, _mm_loadu_si128((const __m128i*)(p + i)));
+	}
+	alignas(16) int64_t lanes[2];
+	_mm_store_si128((__m128i*)lanes, acc);
+	return lanes[0] + lanes[1] + simdSumScalar(p + i, n - i);
+}
+
+SIMD_TARGET("sse2") inline double simdSumSse2(const float* p, size_t n)
+{
+	__m128d acc = _mm_setzero_pd();
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(p + i);
+		acc = _mm_add_pd(acc, _mm_cvtps_pd(x));
+		acc = _mm_add_pd(acc, _mm_cvtps_pd(_mm_movehl_ps(x, x)));
+	}
+	alignas(16) double lanes[2];
+	_mm_store_pd(lanes, acc);
+	return lanes[0] + lanes[1] + simdSumScalar(p + i, n - i);
+}
+
+SIMD_TARGET("sse2") inline double simdSumSse2(const double* p, size_t n)
+{
+	__m128d acc = _mm_setzero_pd();
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2)
+	{
+		acc = _mm_add_pd(acc, _mm_loadu_pd(p + i));
+	}
+	alignas(16) double lanes[2];
+	_mm_store_pd(lanes, acc);
+	return lanes[0] + lanes[1] + simdSumScalar(p + i, n - i);
+}
+
+SIMD_TARGET("sse2") inline std::pair<int32_t, int32_t> simdMinMaxSse2(const int32_t* p, size_t n)
+{
+	__m128i mn = _mm_set1_epi32(INT32_MAX);
+	__m128i mx = _mm_set1_epi32(INT32_MIN);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		//SSE2û32λmin/maxñȽϽѡ
+		__m128i x = _mm_loadu_si128((const __m128i*)(p + i));
+		__m128i lt = _mm_cmplt_epi32(x, mn);
+		mn = _mm_or_si128(_mm_and_si128(lt, x), _mm_andnot_si128(lt, mn));
+		__m128i gt = _mm_cmpgt_epi32(x, mx);
+		mx = _mm_or_si128(_mm_and_si128(gt, x), _mm_andnot_si128(gt, mx));
+	}
+	alignas(16) int32_t mins[4];
+	alignas(16) int32_t maxs[4];
+	_mm_store_si128((__m128i*)mins, mn);
+	_mm_store_si128((__m128i*)maxs, mx);
+	auto rest = simdMinMaxScalar(p + i, n - i);
+	return { std::min({ rest.first, mins[0], mins[1], mins[2], mins[3] }),
+		std::max({ rest.second, maxs[0], maxs[1], maxs[2], maxs[3] }) };
+}
+
+//SSE2û64λȽ
+inline std::pair<int64_t, int64_t> simdMinMaxSse2(const int64_t* p, size_t n)
+{
+	return simdMinMaxScalar(p, n);
+}
+
+SIMD_TARGET("sse2") inline std::pair<float, float> simdMinMaxSse2(const float* p, size_t n)
+{
+	__m128 mn = _mm_set1_ps(std::numeric_limits<float>::max());
+	__m128 mx = _mm_set1_ps(std::numeric_limits<float>::lowest());
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(p + i);
+		mn = _mm_min_ps(mn, x);
+		mx = _mm_max_ps(mx, x);
+	}
+	alignas(16) float mins[4];
+	alignas(16) float maxs[4];
+	_mm_store_ps(mins, mn);
+	_mm_store_ps(maxs, mx);
+	auto rest = simdMinMaxScalar(p + i, n - i);
+	return { std::min({ rest.first, mins[0], mins[1], mins[2], mins[3] }),
+		std::max({ rest.second, maxs[0], maxs[1], maxs[2], maxs[3] }) };
+}
+
+SIMD_TARGET("sse2") inline std::pair<double, double> simdMinMaxSse2(const double* p, size_t n)
+{
+	__m128d mn = _mm_set1_pd(std::numeric_limits<double>::max());
+	__m128d mx = _mm_set1_pd(std::numeric_limits<double>::lowest());
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2)
+	{
+		__m128d x = _mm_loadu_pd(p + i);
+		mn = _mm_min_pd(mn, x);
+		mx = _mm_max_pd(mx, x);
+	}
+	alignas(16) double mins[2];
+	alignas(16) double maxs[2];
+	_mm_store_pd(mins, mn);
+	_mm_store_pd(maxs, mx);
+	auto rest = simdMinMaxScalar(p + i, n - i);
+	return { std::min({ rest.first, mins[0], mins[1] }), std::max({ rest.second, maxs[0], maxs[1] }) };
+}
+
+//SSE2ûз32λ˷64λ˷
+inline int64_t simdDotSse2(const int32_t* a, const int32_t* b, size_t n)
+{
+	return simdDotScalar(a, b, n);
+}
+
+inline int64_t simdDotSse2(const int64_t* a, const int64_t* b, size_t n)
+{
+	return simdDotScalar(a, b, n);
+}
+
+SIMD_TARGET("sse2") inline double simdDotSse2(const float* a, const float* b, size_t n)
+{
+	__m128d acc = _mm_setzero_pd();
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(a + i);
+		__m128 y = _mm_loadu_ps(b + i);
+		acc = _mm_add_pd(acc, _mm_mul_pd(_mm_cvtps_pd(x), _mm_cvtps_pd(y)));
+		acc = _mm_add_pd(acc, _mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(x, x)), _mm_cvtps_pd(_mm_movehl_ps(y, y))));
+	}
+	alignas(16) double lanes[2];
+	_mm_store_pd(lanes, acc);
+	return lanes[0] + lanes[1] + simdDotScalar(a + i, b + i, n - i);
+}
+
+SIMD_TARGET("sse2") inline double simdDotSse2(const double* a, const double* b, size_t n)
+{
+	__m128d acc = _mm_setzero_pd();
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2)
+	{
+		acc = _mm_add_pd(acc, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+	}
+	alignas(16) double lanes[2];
+	_mm_store_pd(lanes, acc);
+	return lanes[0] + lanes[1] + simdDotScalar(a + i, b + i, n - i);
+}
+
+//----------------------------------------AVX2----------------------------------------
+
+SIMD_TARGET("avx2") inline int64_t simdSumAvx2(const int32_t* p, size_t n)
+{
+	__m256i acc = _mm256_setzero_si256();
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256i x = _mm256_loadu_si256((const __m256i*)(p + i));
+		acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(x)));
+		acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(x, 1)));
+	}
+	alignas(32) int64_t lanes[4];
+	_mm256_store_si256((__m256i*)lanes, acc);
+	return lanes[0] + lanes[1] + lanes[2] + lanes[3] + simdSumScalar(p + i, n - i);
+}
+
+SIMD_TARGET("avx2") inline int64_t simdSumAvx2(const int64_t* p, size_t n)
+{
+	__m256i acc = _mm256_setzero_si256();
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		acc = _mm256_add_epi64(acc, _mm256_loadu_si256((const __m256i*)(p + i)));
+	}
+	alignas(32) int64_t lanes[4];
+	_mm256_store_si256((__m256i*)lanes, acc);
+	return lanes[0] + lanes[1] + lanes[2] + lanes[3] + simdSumScalar(p + i, n - i);
+}
+
+SIMD_TARGET("avx2") inline double simdSumAvx2(const float* p, size_t n)
+{
+	__m256d acc = _mm256_setzero_pd();
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		acc = _mm256_add_pd(acc, _mm256_cvtps_pd(_mm_loadu_ps(p + i)));
+		acc = _mm256_add_pd(acc, _mm256_cvtps_pd(_mm_loadu_ps(p + i + 4)));
+	}
+	alignas(32) double lanes[4];
+	_mm256_store_pd(lanes, acc);
+	return lanes[0] + lanes[1] + lanes[2] + lanes[3] + simdSumScalar(p + i, n - i);
+}
+
+SIMD_TARGET("avx2") inline double simdSumAvx2(const double* p, size_t n)
+{
+	__m256d acc = _mm256_setzero_pd();
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		acc = _mm256_add_pd(acc, _mm256_loadu_pd(p + i));
+	}
+	alignas(32) double lanes[4];
+	_mm256_store_pd(lanes, acc);
+	return lanes[0] + lanes[1] + lanes[2] + lanes[3] + simdSumScalar(p + i, n - i);
+}
+
+SIMD_TARGET("avx2") inline std::pair<int32_t, int32_t> simdMinMaxAvx2(const int32_t* p, size_t n)
+{
+	__m256i mn = _mm256_set1_epi32(INT32_MAX);
+	__m256i mx = _mm256_set1_epi32(INT32_MIN);
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256i x = _mm256_loadu_si256((const __m256i*)(p + i));
+		mn = _mm256_min_epi32(mn, x);
+		mx = _mm256_max_epi32(mx, x);
+	}
+	alignas(32) int32_t mins[8];
+	alignas(32) int32_t maxs[8];
+	_mm256_store_si256((__m256i*)mins, mn);
+	_mm256_store_si256((__m256i*)maxs, mx);
+	auto rest = simdMinMaxScalar(p + i, n - i);
+	return { std::min(rest.first, *std::min_element(mins, mins + 8)), std::max(rest.second, *std::max_element(maxs, maxs + 8)) };
+}
+
+SIMD_TARGET("avx2") inline std::pair<int64_t, int64_t> simdMinMaxAvx2(const int64_t* p, size_t n)
+{
+	__m256i mn = _mm256_set1_epi64x(INT64_MAX);
+	__m256i mx = _mm256_set1_epi64x(INT64_MIN);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		//AVX2û64λmin/maxñȽϽѡ
+		__m256i x = _mm256_loadu_si256((const __m256i*)(p + i));
+		mn = _mm256_blendv_epi8(mn, x, _mm256_cmpgt_epi64(mn, x));
+		mx = _mm256_blendv_epi8(mx, x, _mm256_cmpgt_epi64(x, mx));
+	}
+	alignas(32) int64_t mins[4];
+	alignas(32) int64_t maxs[4];
+	_mm256_store_si256((__m256i*)mins, mn);
+	_mm256_store_si256((__m256i*)maxs, mx);
+	auto rest = simdMinMaxScalar(p + i, n - i);
+	return { std::min(rest.first, *std::min_element(mins, mins + 4)), std::max(rest.second, *std::max_element(maxs, maxs + 4)) };
+}
+
+SIMD_TARGET("avx2") inline std::pair<float, float> simdMinMaxAvx2(const float* p, size_t n)
+{
+	__m256 mn = _mm256_set1_ps(std::numeric_limits<float>::max());
+	__m256 mx = _mm256_set1_ps(std::numeric_limits<float>::lowest());
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256 x = _mm256_loadu_ps(p + i);
+		mn = _mm256_min_ps(mn, x);
+		mx = _mm256_max_ps(mx, x);
+	}
+	alignas(32) float mins[8];
+	alignas(32) float maxs[8];
+	_mm256_store_ps(mins, mn);
+	_mm256_store_ps(maxs, mx);
+	auto rest = simdMinMaxScalar(p + i, n - i);
+	return { std::min(rest.first, *std::min_element(mins, mins + 8)), std::max(rest.second, *std::max_element(maxs, maxs + 8)) };
+}
+
+SIMD_TARGET("avx2") inline std::pair<double, double> simdMinMaxAvx2(const double* p, size_t n)
+{
+	__m256d mn = _mm256_set1_pd(std::numeric_limits<double>::max());
+	__m256d mx = _mm256_set1_pd(std::numeric_limits<double>::lowest());
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m256d x = _mm256_loadu_pd(p + i);
+		mn = _mm256_min_pd(mn, x);
+		mx = _mm256_max_pd(mx, x);
+	}
+	alignas(32) double mins[4];
+	alignas(32) double maxs[4];
+	_mm256_store_pd(mins, mn);
+	_mm256_store_pd(maxs, mx);
+	auto rest = simdMinMaxScalar(p + i, n - i);
+	return { std::min(rest.first, *std::min_element(mins, mins + 4)), std::max(rest.second, *std::max_element(maxs, maxs + 4)) };
+}
+
+SIMD_TARGET("avx2") inline int64_t simdDotAvx2(const int32_t* a, const int32_t* b, size_t n)
+{
+	__m256i acc = _mm256_setzero_si256();
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		//չ64λmul_epi3232λз˵õ64λ˻
+		__m256i x = _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(a + i)));
+		__m256i y = _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(b + i)));
+		acc = _mm256_add_epi64(acc, _mm256_mul_epi32(x, y));
+	}
+	alignas(32) int64_t lanes[4];
+	_mm256_store_si256((__m256i*)lanes, acc);
+	return lanes[0] + lanes[1] + lanes[2] + lanes[3] + simdDotScalar(a + i, b + i, n - i);
+}
+
+//AVX2û64λ˷
+inline int64_t simdDotAvx2(const int64_t* a, const int64_t* b, size_t n)
+{
+	return simdDotScalar(a, b, n);
+}
+
+SIMD_TARGET("avx2") inline double simdDotAvx2(const float* a, const float* b, size_t n)
+{
+	__m256d acc = _mm256_setzero_pd();
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m256d x = _mm256_cvtps_pd(_mm_loadu_ps(a + i));
+		__m256d y = _mm256_cvtps_pd(_mm_loadu_ps(b + i));
+		acc = _mm256_add_pd(acc, _mm256_mul_pd(x, y));
+	}
+	alignas(32) double lanes[4];
+	_mm256_store_pd(lanes, acc);
+	return lanes[0] + lanes[1] + lanes[2] + lanes[3] + simdDotScalar(a + i, b + i, n - i);
+}
+
+SIMD_TARGET("avx2") inline double simdDotAvx2(const double* a, const double* b, size_t n)
+{
+	__m256d acc = _mm256_setzero_pd();
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		acc = _mm256_add_pd(acc, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+	}
+	alignas(32) double lanes[4];
+	_mm256_store_pd(lanes, acc);
+	return lanes[0] + lanes[1] + lanes[2] + lanes[3] + simdDotScalar(a + i, b + i, n - i);
+}
+
+//floatֱͼһ8ԪصͰ±꣬Ȼۼ
+//ΧжϺͰ±궼תdouble㣬simdHistogramScalarȫһ£Ͱ߽ҲֵͬͰ
+SIMD_TARGET("avx2") inline void simdHistogramAvx2(const float* p, size_t n, const HistogramRange& range, uint64_t* counts)
+{
+	__m256d lo = _mm256_set1_pd(range.lo);
+	__m256d hi = _mm256_set1_pd(range.hi);
+	__m256d scale = _mm256_set1_pd(range.scale);
+	__m128i last = _mm_set1_epi32((int)range.bins - 1);
+	alignas(16) int32_t bins[8];
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256 x = _mm256_loadu_ps(p + i);
+		__m256d xLow = _mm256_cvtps_pd(_mm256_castps256_ps128(x));
+		__m256d xHigh = _mm256_cvtps_pd(_mm256_extractf128_ps(x, 1));
+		int valid = _mm256_movemask_pd(_mm256_and_pd(_mm256_cmp_pd(xLow, lo, _CMP_GE_OQ), _mm256_cmp_pd(xLow, hi, _CMP_LT_OQ)))
+			| (_mm256_movemask_pd(_mm256_and_pd(_mm256_cmp_pd(xHigh, lo, _CMP_GE_OQ), _mm256_cmp_pd(xHigh, hi, _CMP_LT_OQ))) << 4);
+		//ΧԪ±û壬水valid
+		_mm_store_si128((__m128i*)bins, _mm_min_epi32(_mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_sub_pd(xLow, lo), scale)), last));
+		_mm_store_si128((__m128i*)(bins + 4), _mm_min_epi32(_mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_sub_pd(xHigh, lo), scale)), last));
+		for (int k = 0; k < 8; k++)
+		{
+			if (valid & (1 << k))
+			{
+				counts[(k & 3) * range.bins + bins[k]]++;
+			}
+		}
+	}
+	simdHistogramScalar(p + i, n - i, range, counts);
+}
+
+//----------------------------------------AVX-512----------------------------------------
+
+//gcc 12avx512fintrin.h_mm512_castsi512_si256_mm512_reduce_*δʼֻһιص
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+SIMD_TARGET("avx512f") inline int64_t simdSumAvx512(const int32_t* p, size_t n)
+{
+	__m512i acc = _mm512_setzero_si512();
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16)
+	{
+		__m512i x = _mm512_loadu_si512((const void*)(p + i));
+		acc = _mm512_add_epi64(acc, _mm512_cvtepi32_epi64(_mm512_castsi512_si256(x)));
+		acc = _mm512_add_epi64(acc, _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(x, 1)));
+	}
+	return _mm512_reduce_add_epi64(acc) + simdSumScalar(p + i, n - i);
+}
+
+SIMD_TARGET("avx512f") inline int64_t simdSumAvx512(const int64_t* p, size_t n)
+{
+	__m512i acc = _mm512_setzero_si512();
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		acc = _mm512_add_epi64(acc, _mm512_loadu_si512((const void*)(p + i)));
+	}
+	return _mm512_reduce_add_epi64(acc) + simdSumScalar(p + i, n - i);
+}
+
+SIMD_TARGET("avx512f") inline double simdSumAvx512(const float* p, size_t n)
+{
+	__m512d acc = _mm512_setzero_pd();
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16)
+	{
+		acc = _mm512_add_pd(acc, _mm512_cvtps_pd(_mm256_loadu_ps(p + i)));
+		acc = _mm512_add_pd(acc, _mm512_cvtps_pd(_mm256_loadu_ps(p + i + 8)));
+	}
+	return _mm512_reduce_add_pd(acc) + simdSumScalar(p + i, n - i);
+}
+
+SIMD_TARGET("avx512f") inline double simdSumAvx512(const double* p, size_t n)
+{
+	__m512d acc = _mm512_setzero_pd();
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		acc = _mm512_add_pd(acc, _mm512_loadu_pd(p + i));
+	}
+	return _mm512_reduce_add_pd(acc) + simdSumScalar(p + i, n - i);
+}
+
+SIMD_TARGET("avx512f") inline std::pair<int32_t, int32_t> simdMinMaxAvx512(const int32_t* p, size_t n)
+{
+	__m512i mn = _mm512_set1_epi32(INT32_MAX);
+	__m512i mx = _mm512_set1_epi32(INT32_MIN);
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16)
+	{
+		__m512i x = _mm512_loadu_si512((const void*)(p + i));
+		mn = _mm512_min_epi32(mn, x);
+		mx = _mm512_max_epi32(mx, x);
+	}
+	auto rest = simdMinMaxScalar(p + i, n - i);
+	return { std::min(rest.first, (int32_t)_mm512_reduce_min_epi32(mn)), std::max(rest.second, (int32_t)_mm512_reduce_max_epi32(mx)) };
+}
+
+SIMD_TARGET("avx512f") inline std::pair<int64_t, int64_t> simdMinMaxAvx512(const int64_t* p, size_t n)
+{
+	__m512i mn = _mm512_set1_epi64(INT64_MAX);
+	__m512i mx = _mm512_set1_epi64(INT64_MIN);
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m512i x = _mm512_loadu_si512((const void*)(p + i));
+		mn = _mm512_min_epi64(mn, x);
+		mx = _mm512_max_epi64(mx, x);
+	}
+	auto rest = simdMinMaxScalar(p + i, n - i);
+	return { std::min(rest.first, (int64_t)_mm512_reduce_min_epi64(mn)), std::max(rest.second, (int64_t)_mm512_reduce_max_epi64(mx)) };
+}
+
+SIMD_TARGET("avx512f") inline std::pair<float, float> simdMinMaxAvx512(const float* p, size_t n)
+{
+	__m512 mn = _mm512_set1_ps(std::numeric_limits<float>::max());
+	__m512 mx = _mm512_set1_ps(std::numeric_limits<float>::lowest());
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16)
+	{
+		__m512 x = _mm512_loadu_ps(p + i);
+		mn = _mm512_min_ps(mn, x);
+		mx = _mm512_max_ps(mx, x);
+	}
+	auto rest = simdMinMaxScalar(p + i, n - i);
+	return { std::min(rest.first, (float)_mm512_reduce_min_ps(mn)), std::max(rest.second, (float)_mm512_reduce_max_ps(mx)) };
+}
+
+SIMD_TARGET("avx512f") inline std::pair<double, double> simdMinMaxAvx512(const double* p, size_t n)
+{
+	__m512d mn = _mm512_set1_pd(std::numeric_limits<double>::max());
+	__m512d mx = _mm512_set1_pd(std::numeric_limits<double>::lowest());
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m512d x = _mm512_loadu_pd(p + i);
+		mn = _mm512_min_pd(mn, x);
+		mx = _mm512_max_pd(mx, x);
+	}
+	auto rest = simdMinMaxScalar(p + i, n - i);
+	return { std::min(rest.first, (double)_mm512_reduce_min_pd(mn)), std::max(rest.second, (double)_mm512_reduce_max_pd(mx)) };
+}
+
+SIMD_TARGET("avx512f") inline int64_t simdDotAvx512(const int32_t* a, const int32_t* b, size_t n)
+{
+	__m512i acc = _mm512_setzero_si512();
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m512i x = _mm512_cvtepi32_epi64(_mm256_loadu_si256((const __m256i*)(a + i)));
+		__m512i y = _mm512_cvtepi32_epi64(_mm256_loadu_si256((const __m256i*)(b + i)));
+		acc = _mm512_add_epi64(acc, _mm512_mul_epi32(x, y));
+	}
+	return _mm512_reduce_add_epi64(acc) + simdDotScalar(a + i, b + i, n - i);
+}
+
+//64λ˷ҪAVX-512DQֻҪAVX-512F
+inline int64_t simdDotAvx512(const int64_t* a, const int64_t* b, size_t n)
+{
+	return simdDotScalar(a, b, n);
+}
+
+SIMD_TARGET("avx512f") inline double simdDotAvx512(const float* a, const float* b, size_t n)
+{
+	__m512d acc = _mm512_setzero_pd();
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m512d x = _mm512_cvtps_pd(_mm256_loadu_ps(a + i));
+		__m512d y = _mm512_cvtps_pd(_mm256_loadu_ps(b + i));
+		acc = _mm512_add_pd(acc, _mm512_mul_pd(x, y));
+	}
+	return _mm512_reduce_add_pd(acc) + simdDotScalar(a + i, b + i, n - i);
+}
+
+SIMD_TARGET("avx512f") inline double simdDotAvx512(const double* a, const double* b, size_t n)
+{
+	__m512d acc = _mm512_setzero_pd();
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		acc = _mm512_add_pd(acc, _mm512_mul_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i)));
+	}
+	return _mm512_reduce_add_pd(acc) + simdDotScalar(a + i, b + i, n - i);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif
+
+//----------------------------------------ָ----------------------------------------
+
+//SIMDʵֵԪ
+template<typename T>
+constexpr bool isSimdType()
+{
+	return std::is_same<T, int32_t>::value || std::is_same<T, int64_t>::value
+		|| std::is_same<T, float>::value || std::is_same<T, double>::value;
+}
+
+template<typename T>
+SimdSumType<T> simdSum(const T* p, size_t n)
+{
+#ifdef THREADPOOL_SIMD_X86
+	if constexpr (isSimdType<T>())
+	{
+		switch (simdLevel())
+		{
+		case SimdLevel::SIMD_AVX512:
+			return simdSumAvx512(p, n);
+		case SimdLevel::SIMD_AVX2:
+			return simdSumAvx2(p, n);
+		case SimdLevel::SIMD_SSE2:
+			return simdSumSse2(p, n);
+		default:
+			break;
+		}
+	}
+#endif
+	return simdSumScalar(p, n);
+}
+
+template<typename T>
+std::pair<T, T> simdMinMax(const T* p, size_t n)
+{
+#ifdef THREADPOOL_SIMD_X86
+	if constexpr (isSimdType<T>())
+	{
+		switch (simdLevel())
+		{
+		case SimdLevel::SIMD_AVX512:
+			return simdMinMaxAvx512(p, n);
+		case SimdLevel::SIMD_AVX2:
+			return simdMinMaxAvx2(p, n);
+		case SimdLevel::SIMD_SSE2:
+			return simdMinMaxSse2(p, n);
+		default:
+			break;
+		}
+	}
+#endif
+	return simdMinMaxScalar(p, n);
+}
+
+template<typename T>
+SimdSumType<T> simdDot(const T* a, const T* b, size_t n)
+{
+#ifdef THREADPOOL_SIMD_X86
+	if constexpr (isSimdType<T>())
+	{
+		switch (simdLevel())
+		{
+		case SimdLevel::SIMD_AVX512:
+			return simdDotAvx512(a, b, n);
+		case SimdLevel::SIMD_AVX2:
+			return simdDotAvx2(a, b, n);
+		case SimdLevel::SIMD_SSE2:
+			return simdDotSse2(a, b, n);
+		default:
+			break;
+		}
+	}
+#endif
+	return simdDotScalar(a, b, n);
+}
+
+template<typename T>
+void simdHistogram(const T* p, size_t n, const HistogramRange& range, uint64_t* counts)
+{
+#ifdef THREADPOOL_SIMD_X86
+	//floatתdoubleǾȷģdoubleͰ±꣬ͱһ£ֻfloatʹ
+	if constexpr (std::is_same<T, float>::value)
+	{
+		if (simdLevel() >= SimdLevel::SIMD_AVX2)
+		{
+			simdHistogramAvx2(p, n, range, counts);
+			return;
+		}
+	}
+#endif
+	simdHistogramScalar(p, n, range, counts);
+}
+
+//----------------------------------------̳߳صĲйԼ----------------------------------------
+
+//algoChunkCountֿ飬βÿʼַ뵽SIMD_CHUNK_ALIGNֽ
+template<typename Pool, typename T>
+std::vector<size_t> simdChunkBounds(Pool& pool, const T* data, size_t n)
+{
+	size_t chunks = algoChunkCount(pool, n);
+	size_t lane = 1;
+	size_t skew = 0;
+	if (SIMD_CHUNK_ALIGN % sizeof(T) == 0 && (uintptr_t)data % sizeof(T) == 0)
+	{
+		lane = SIMD_CHUNK_ALIGN / sizeof(T);
+		skew = ((uintptr_t)data % SIMD_CHUNK_ALIGN) / sizeof(T);
+	}
+	std::vector<size_t> bounds(1, 0);
+	for (size_t i = 1; i < chunks; i++)
+	{
+		size_t bound = (n * i / chunks + skew + lane - 1) / lane * lane - skew;
+		bounds.push_back(std::min(std::max(bound, bounds.back()), n));
+	}
+	bounds.push_back(n);
+	return bounds;
+}
+
+//ͣ64λۼӣdoubleۼ
+template<typename Pool, typename T>
+SimdSumType<T> parallelSum(Pool& pool, const T* data, size_t n)
+{
+	std::vector<size_t> bounds = simdChunkBounds(pool, data, n);
+	std::vector<SimdSumType<T>> parts(bounds.size() - 1);
+	algoForChunks(pool, parts.size(), parts.size(), [&](size_t i, size_t, size_t) {
+		parts[i] = simdSum(data + bounds[i], bounds[i + 1] - bounds[i]);
+	});
+	return std::accumulate(parts.begin(), parts.end(), SimdSumType<T>());
+}
+
+//СֵֵnΪ0ʱ{ max(), lowest() }
+template<typename Pool, typename T>
+std::pair<T, T> parallelMinMax(Pool& pool, const T* data, size_t n)
+{
+	std::vector<size_t> bounds = simdChunkBounds(pool, data, n);
+	std::vector<std::pair<T, T>> parts(bounds.size() - 1);
+	algoForChunks(pool, parts.size(), parts.size(), [&](size_t i, size_t, size_t) {
+		parts[i] = simdMinMax(data + bounds[i], bounds[i + 1] - bounds[i]);
+	});
+	std::pair<T, T> result(std::numeric_limits<T>::max(), std::numeric_limits<T>::lowest());
+	for (auto& part : parts)
+	{
+		result.first = std::min(result.first, part.first);
+		result.second = std::max(result.second, part.second);
+	}
+	return result;
+}
+
+//еֿ鰴a
+template<typename Pool, typename T>
+SimdSumType<T> parallelDot(Pool& pool, const T* a, const T* b, size_t n)
+{
+	std::vector<size_t> bounds = simdChunkBounds(pool, a, n);
+	std::vector<SimdSumType<T>> parts(bounds.size() - 1);
+	algoForChunks(pool, parts.size(), parts.size(), [&](size_t i, size_t, size_t) {
+		parts[i] = simdDot(a + bounds[i], b + bounds[i], bounds[i + 1] - bounds[i]);
+	});
+	return std::accumulate(parts.begin(), parts.end(), SimdSumType<T>());
+}
+
+//ֱͼ[lo, hi)ֳbinsͰΧԪز
+//ÿͳƵԼļϲ֮߳ûйд
+template<typename Pool, typename T>
+std::vector<uint64_t> parallelHistogram(Pool& pool, const T* data, size_t n, T lo, T hi, size_t bins)
+{
+	std::vector<uint64_t> result(bins);
+	if (bins == 0 || !(lo < hi))
+	{
+		return result;
+	}
+	HistogramRange range{ (double)lo, (double)hi, (double)bins / ((double)hi - (double)lo), bins };
+	std::vector<size_t> bounds = simdChunkBounds(pool, data, n);
+	std::vector<std::vector<uint64_t>> parts(bounds.size() - 1);
+	algoForChunks(pool, parts.size(), parts.size(), [&](size_t i, size_t, size_t) {
+		parts[i].assign(4 * bins, 0);
+		simdHistogram(data + bounds[i], bounds[i + 1] - bounds[i], range, parts[i].data());
+	});
+	for (auto& part : parts)
+	{
+		for (size_t k = 0; k < 4 * bins; k++)
+		{
+			result[k % bins] += part[k];
+		}
+	}
+	return result;
+}
+
+#endif
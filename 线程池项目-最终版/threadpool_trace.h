@@ -0,0 +1,322 @@
+#ifndef THREADPOOL_TRACE_H
+#define THREADPOOL_TRACE_H
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <functional>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+
+/*
+̳߳ص켣¼tools/threadpool_replay.cpp߻ط
+pool.startRecording("pool.trace");
+...
+pool.stopRecording();
+
+ļʽСˣ
+ļͷ   char magic[8] = "TPTRACE1"uint32 tickNs
+ݿ   uint32 typeuint32 count
+	TRACE_BLOCK_TASKS   countTraceRecord
+	TRACE_BLOCK_CLASS   uint32 classId + countֽڵ
+ύʱĿɵö֣ÿlambdaָ͸һ
+*/
+
+const char TRACE_MAGIC[8] = { 'T', 'P', 'T', 'R', 'A', 'C', 'E', '1' };
+const uint32_t TRACE_TICK_NS = 100;//ʱ䵥λ100룬32λԱʾ400
+const uint32_t TRACE_BLOCK_TASKS = 1;
+const uint32_t TRACE_BLOCK_CLASS = 2;
+const size_t TRACE_BUFFER_SIZE = 4096;//ÿܹ߳ô¼дļ
+
+//ļеһ¼24ֽ
+struct TraceRecord
+{
+	uint64_t submitTick; //Կʼ¼ύʱ
+	uint32_t waitTick;   //Ŷʱ
+	uint32_t execTick;   //ִʱ
+	uint32_t classId;    //
+	uint32_t worker;     //ִеĹ߳id
+};
+
+//߳ڴеļ¼дļʱٻ
+struct TraceEvent
+{
+	const char* taskClass;
+	std::chrono::steady_clock::time_point submitTime;
+	std::chrono::steady_clock::time_point startTime;
+	std::chrono::steady_clock::time_point endTime;
+	uint32_t worker;
+};
+
+inline uint32_t traceClassId(const char* taskClass)
+{
+	return (uint32_t)std::hash<std::string>()(taskClass != nullptr ? taskClass : "unknown");
+}
+
+//ÿ߳һ¼ʱֻԼûо
+class TraceBuffer
+{
+public:
+	TraceBuffer()
+	{
+		events_.reserve(TRACE_BUFFER_SIZE);
+	}
+
+private:
+	friend class TraceRecorder;
+	std::mutex mtx_;
+	std::condition_variable idle_;
+	std::vector<TraceEvent> events_;
+	bool isClosed_ = false;
+	bool isRunning_ = false; //ִ߳һҪ¼񣬽¼ʱҪ
+};
+
+class TraceRecorder
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	TraceRecorder() = default;
+
+	~TraceRecorder()
+	{
+		close();
+	}
+
+	bool open(const std::string& path)
+	{
+		file_ = std::fopen(path.c_str(), "wb");
+		if (file_ == nullptr)
+		{
+			std::cerr << "open trace file fail: " << path << std::endl;
+			return false;
+		}
+		startTime_ = Clock::now();
+		std::fwrite(TRACE_MAGIC, 1, sizeof(TRACE_MAGIC), file_);
+		std::fwrite(&TRACE_TICK_NS, sizeof(TRACE_TICK_NS), 1, file_);
+		return true;
+	}
+
+	//һ̷߳仺
+	TraceBuffer* newBuffer()
+	{
+		std::lock_guard<std::mutex> lock(fileMtx_);
+		buffers_.emplace_back(std::make_unique<TraceBuffer>());
+		buffers_.back()->isClosed_ = (file_ == nullptr || isClosing_);
+		return buffers_.back().get();
+	}
+
+	//ʼִǰãrecord
+	//futurerecord֮ǰѾcloseҪִе꣬÷ɵŲ©
+	void begin(TraceBuffer* buffer)
+	{
+		std::lock_guard<std::mutex> lock(buffer->mtx_);
+		if (!buffer->isClosed_)
+		{
+			buffer->isRunning_ = true;
+			runningBuffer() = buffer;
+		}
+	}
+
+	//¼һ񣬻˲дļ
+	void record(TraceBuffer* buffer, const TraceEvent& event)
+	{
+		std::vector<TraceEvent> full;
+		{
+			std::lock_guard<std::mutex> lock(buffer->mtx_);
+			//close֮ſʼ񲻼¼ʼ¼֮ǰύûŶʱ䣬Ҳ¼
+			if (buffer->isRunning_ && event.submitTime >= startTime_)
+			{
+				buffer->events_.push_back(event);
+				if (buffer->events_.size() >= TRACE_BUFFER_SIZE)
+				{
+					full.reserve(TRACE_BUFFER_SIZE);
+					full.swap(buffer->events_);
+				}
+			}
+		}
+		//дļ꣬close֮ǰرļ
+		if (!full.empty())
+		{
+			std::lock_guard<std::mutex> lock(fileMtx_);
+			writeEvents(full);
+		}
+		std::lock_guard<std::mutex> lock(buffer->mtx_);
+		buffer->isRunning_ = false;
+		runningBuffer() = nullptr;
+		buffer->idle_.notify_all();
+	}
+
+	//ִе꣬длеļ¼رļ֮ʼټ¼
+	//ڱ¼ʱԼ
+	void close()
+	{
+		std::vector<TraceBuffer*> buffers;
+		{
+			std::lock_guard<std::mutex> lock(fileMtx_);
+			if (file_ == nullptr)
+			{
+				return;
+			}
+			isClosing_ = true;
+			for (auto& buffer : buffers_)
+			{
+				buffers.push_back(buffer.get());
+			}
+		}
+		for (TraceBuffer* buffer : buffers)
+		{
+			std::unique_lock<std::mutex> bufLock(buffer->mtx_);
+			buffer->isClosed_ = true;
+			buffer->idle_.wait(bufLock, [&]()->bool { return !buffer->isRunning_ || buffer == runningBuffer(); });
+		}
+
+		std::lock_guard<std::mutex> lock(fileMtx_);
+		if (file_ == nullptr)
+		{
+			return;
+		}
+		for (auto& buffer : buffers_)
+		{
+			std::vector<TraceEvent> rest;
+			{
+				std::lock_guard<std::mutex> bufLock(buffer->mtx_);
+				rest.swap(buffer->events_);
+			}
+			writeEvents(rest);
+		}
+		std::fclose(file_);
+		file_ = nullptr;
+	}
+
+	TraceRecorder(const TraceRecorder&) = delete;
+	TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+private:
+	//ǰִ߳еı¼Ļ
+	static TraceBuffer*& runningBuffer()
+	{
+		thread_local TraceBuffer* buffer = nullptr;
+		return buffer;
+	}
+
+	static uint32_t toTick(Clock::duration dur)
+	{
+		int64_t tick = std::chrono::duration_cast<std::chrono::nanoseconds>(dur).count() / TRACE_TICK_NS;
+		return (uint32_t)std::min<int64_t>(std::max<int64_t>(tick, 0), UINT32_MAX);
+	}
+
+	//÷fileMtx_
+	void writeEvents(const std::vector<TraceEvent>& events)
+	{
+		if (events.empty() || file_ == nullptr)
+		{
+			return;
+		}
+		std::vector<TraceRecord> records;
+		records.reserve(events.size());
+		for (const TraceEvent& event : events)
+		{
+			const char* name = event.taskClass != nullptr ? event.taskClass : "unknown";
+			uint32_t classId = traceClassId(name);
+			if (classes_.insert(classId).second)
+			{
+				//һγֵ࣬д
+				uint32_t header[3] = { TRACE_BLOCK_CLASS, (uint32_t)std::strlen(name), classId };
+				std::fwrite(header, sizeof(header), 1, file_);
+				std::fwrite(name, 1, header[1], file_);
+			}
+			TraceRecord record;
+			record.submitTick = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(event.submitTime - startTime_).count() / TRACE_TICK_NS;
+			record.waitTick = toTick(event.startTime - event.submitTime);
+			record.execTick = toTick(event.endTime - event.startTime);
+			record.classId = classId;
+			record.worker = event.worker;
+			records.push_back(record);
+		}
+		uint32_t header[2] = { TRACE_BLOCK_TASKS, (uint32_t)records.size() };
+		std::fwrite(header, sizeof(header), 1, file_);
+		std::fwrite(records.data(), sizeof(TraceRecord), records.size(), file_);
+	}
+
+private:
+	std::mutex fileMtx_; //ļbuffers_classes_
+	std::FILE* file_ = nullptr;
+	bool isClosing_ = false; //closeѾʼ֮Ļֱӹر
+	Clock::time_point startTime_;
+	std::vector<std::unique_ptr<TraceBuffer>> buffers_;
+	std::unordered_set<uint32_t> classes_; //Ѿд
+};
+
+//Ĺ켣recordsύʱ
+struct TraceData
+{
+	uint32_t tickNs = TRACE_TICK_NS;
+	std::vector<TraceRecord> records;
+	std::unordered_map<uint32_t, std::string> classNames;
+};
+
+inline bool readTrace(const std::string& path, TraceData& trace)
+{
+	std::FILE* file = std::fopen(path.c_str(), "rb");
+	if (file == nullptr)
+	{
+		std::cerr << "open trace file fail: " << path << std::endl;
+		return false;
+	}
+	char magic[sizeof(TRACE_MAGIC)];
+	if (std::fread(magic, 1, sizeof(magic), file) != sizeof(magic)
+		|| std::memcmp(magic, TRACE_MAGIC, sizeof(magic)) != 0
+		|| std::fread(&trace.tickNs, sizeof(trace.tickNs), 1, file) != 1)
+	{
+		std::cerr << "not a threadpool trace file: " << path << std::endl;
+		std::fclose(file);
+		return false;
+	}
+
+	uint32_t header[2];
+	bool isOk = true;
+	while (std::fread(header, sizeof(header), 1, file) == 1)
+	{
+		if (header[0] == TRACE_BLOCK_TASKS)
+		{
+			size_t old = trace.records.size();
+			trace.records.resize(old + header[1]);
+			isOk = std::fread(trace.records.data() + old, sizeof(TraceRecord), header[1], file) == header[1];
+		}
+		else if (header[0] == TRACE_BLOCK_CLASS)
+		{
+			uint32_t classId;
+			std::string name(header[1], '\0');
+			isOk = std::fread(&classId, sizeof(classId), 1, file) == 1
+				&& std::fread(&name[0], 1, name.size(), file) == name.size();
+			trace.classNames[classId] = name;
+		}
+		else
+		{
+			isOk = false;
+		}
+		if (!isOk)
+		{
+			std::cerr << "trace file is broken: " << path << std::endl;
+			break;
+		}
+	}
+	std::fclose(file);
+
+	std::sort(trace.records.begin(), trace.records.end(), [](const TraceRecord& a, const TraceRecord& b) {
+		return a.submitTick < b.submitTick;
+	});
+	return isOk;
+}
+
+#endif
@@ -0,0 +1,122 @@
+﻿// threadpool_algorithms_bench.cpp : 比较threadpool_algorithms.h中的并行算法和串行std::版本的耗时
+//
+// 用法：threadpool_algorithms_bench [-n elements] [-t threads] [-r rounds]
+//   -n           数组元素个数，默认16M
+//   -t           线程数，默认CPU核数
+//   -r           每项测试重复次数，取最快的一次，默认5
+// 线程池本身会往标准输出打印日志，报告输出到标准错误：threadpool_algorithms_bench > /dev/null
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <cstdlib>
+#include "../threadpool.h"
+#include "../threadpool_algorithms.h"
+using namespace std;
+
+using Clock = std::chrono::steady_clock;
+
+//重复执行prepare和fn，只统计fn的耗时，返回最快一次的耗时（毫秒）
+template<typename Prepare, typename Fn>
+double bestOf(int rounds, Prepare prepare, Fn fn)
+{
+	double best = 1e300;
+	for (int i = 0; i < rounds; i++)
+	{
+		prepare();
+		Clock::time_point begin = Clock::now();
+		fn();
+		best = min(best, chrono::duration<double, milli>(Clock::now() - begin).count());
+	}
+	return best;
+}
+
+//打印一行结果，并行结果和串行结果不一致时标出来
+void report(const string& name, double serialMs, double parallelMs, bool isSame)
+{
+	cerr << "  " << left << setw(16) << name << right << setw(12) << serialMs << setw(12) << parallelMs
+		<< setw(10) << serialMs / parallelMs << "x" << (isSame ? "" : "  MISMATCH") << endl;
+}
+
+int main(int argc, char* argv[])
+{
+	size_t n = 16 << 20;
+	int threads = (int)thread::hardware_concurrency();
+	int rounds = 5;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		string arg = argv[i];
+		if (arg == "-n") n = (size_t)atoll(argv[i + 1]);
+		else if (arg == "-t") threads = atoi(argv[i + 1]);
+		else if (arg == "-r") rounds = max(atoi(argv[i + 1]), 1);
+		else
+		{
+			cerr << "unknown option: " << arg << endl;
+			return 1;
+		}
+	}
+
+	ThreadPool pool;
+	pool.start(max(threads, 1));
+	cerr << fixed << setprecision(2);
+	cerr << "threads: " << threads << "  elements: " << n << endl;
+	cerr << "  " << left << setw(16) << "algorithm" << right << setw(12) << "std ms" << setw(12) << "pool ms" << setw(11) << "speedup" << endl;
+
+	mt19937 rng(12345);
+	vector<int> input(n);
+	for (auto& x : input)
+	{
+		x = (int)(rng() % 1000000);
+	}
+	vector<int> serial;
+	vector<int> parallel;
+
+	//排序
+	double serialMs = bestOf(rounds, [&] { serial = input; }, [&] { sort(serial.begin(), serial.end()); });
+	double parallelMs = bestOf(rounds, [&] { parallel = input; }, [&] { parallelSort(pool, parallel.begin(), parallel.end()); });
+	report("sort", serialMs, parallelMs, serial == parallel);
+
+	//transform
+	serial.assign(n, 0);
+	parallel.assign(n, 0);
+	auto square = [](int x) { return (int)((long long)x * x % 1000003); };
+	serialMs = bestOf(rounds, [] {}, [&] { transform(input.begin(), input.end(), serial.begin(), square); });
+	parallelMs = bestOf(rounds, [] {}, [&] { parallelTransform(pool, input.begin(), input.end(), parallel.begin(), square); });
+	report("transform", serialMs, parallelMs, serial == parallel);
+
+	//前缀和，累加用的是输入的元素类型，输入用long long避免溢出
+	vector<long long> values(input.begin(), input.end());
+	vector<long long> serialSum(n);
+	vector<long long> parallelSum(n);
+	serialMs = bestOf(rounds, [] {}, [&] { partial_sum(values.begin(), values.end(), serialSum.begin()); });
+	parallelMs = bestOf(rounds, [] {}, [&] { parallelInclusiveScan(pool, values.begin(), values.end(), parallelSum.begin()); });
+	report("inclusive_scan", serialMs, parallelMs, serialSum == parallelSum);
+
+	//count_if
+	auto isMatch = [](int x) { return x % 7 == 3; };
+	size_t serialCount = 0;
+	size_t parallelCount = 0;
+	serialMs = bestOf(rounds, [] {}, [&] { serialCount = count_if(input.begin(), input.end(), isMatch); });
+	parallelMs = bestOf(rounds, [] {}, [&] { parallelCount = parallelCountIf(pool, input.begin(), input.end(), isMatch); });
+	report("count_if", serialMs, parallelMs, serialCount == parallelCount);
+
+	//find_if，要找的元素放在中间和末尾，看找到后提前结束的效果
+	for (size_t pos : { n / 2, n - 1 })
+	{
+		vector<int> data = input;
+		data[pos] = -1;
+		auto isTarget = [](int x) { return x < 0; };
+		size_t serialPos = 0;
+		size_t parallelPos = 0;
+		serialMs = bestOf(rounds, [] {}, [&] { serialPos = find_if(data.begin(), data.end(), isTarget) - data.begin(); });
+		parallelMs = bestOf(rounds, [] {}, [&] { parallelPos = parallelFindIf(pool, data.begin(), data.end(), isTarget) - data.begin(); });
+		report(pos == n - 1 ? "find_if (end)" : "find_if (mid)", serialMs, parallelMs, serialPos == pos && parallelPos == pos);
+	}
+	return 0;
+}
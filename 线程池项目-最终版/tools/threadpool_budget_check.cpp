@@ -0,0 +1,219 @@
+﻿// threadpool_budget_check.cpp : 检查多个线程池共享的线程预算（ThreadBudget/setThreadBudget）
+//
+// 用法：threadpool_budget_check [-b budget] [-n tasks]
+//   -b           预算上限，默认3，至少2
+//   -n           每个线程池提交的任务数，默认200
+// 线程池本身会往标准输出打印日志，报告输出到标准错误：threadpool_budget_check > /dev/null
+// 全部检查通过时返回0
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <future>
+#include <functional>
+#include <algorithm>
+#include <cstdlib>
+#include "../threadpool.h"
+using namespace std;
+
+using Clock = std::chrono::steady_clock;
+
+int failures = 0;
+
+void report(const string& name, bool ok, const string& detail)
+{
+	cerr << (ok ? "  ok    " : "  FAIL  ") << name << "  " << detail << endl;
+	if (!ok)
+	{
+		failures++;
+	}
+}
+
+//同时执行的任务数和它的峰值
+struct Concurrency
+{
+	atomic<int> running{ 0 };
+	atomic<int> peak{ 0 };
+
+	void enter()
+	{
+		int now = ++running;
+		int old = peak;
+		while (now > old && !peak.compare_exchange_weak(old, now))
+		{
+		}
+	}
+
+	void leave()
+	{
+		running--;
+	}
+};
+
+//保底名额加起来不超过上限，后加入的只能得到剩下的部分，退出后名额可以重新分配
+void checkClamp(int limit)
+{
+	ThreadBudget budget(limit);
+	ThreadBudget::Member* first = budget.join(limit - 1);
+	ThreadBudget::Member* second = budget.join(limit);
+	ThreadBudget::Member* third = budget.join(1);
+	ThreadBudget::Member* negative = budget.join(-1);
+	bool isClamped = first->guaranteed == limit - 1 && second->guaranteed == 1 && third->guaranteed == 0 && negative->guaranteed == 0;
+	budget.leave(first);
+	ThreadBudget::Member* again = budget.join(limit);
+	bool isReused = again->guaranteed == limit - 1;
+	ostringstream detail;
+	detail << "joined " << limit - 1 << "," << limit << ",1,-1 -> " << limit - 1 << "," << second->guaranteed << ","
+		<< third->guaranteed << "," << negative->guaranteed << "; after leave " << limit << " -> " << again->guaranteed;
+	report("guarantee clamping", isClamped && isReused, detail.str());
+}
+
+//两个线程池的线程数都超过预算，所有线程池同时执行的任务数不超过上限，一个线程池空闲时另一个可以用满
+void checkLimit(int limit, int tasks)
+{
+	ThreadBudget budget(limit);
+	ThreadPool a;
+	ThreadPool b;
+	a.setThreadBudget(budget, 1);
+	b.setThreadBudget(budget, 0);
+	a.start(limit * 2);
+	b.start(limit * 2);
+
+	Concurrency all;
+	Concurrency onlyB;
+	int budgetPeak = 0;
+	auto work = [&all](Concurrency* own) {
+		all.enter();
+		if (own != nullptr)
+		{
+			own->enter();
+		}
+		this_thread::sleep_for(chrono::milliseconds(2));
+		if (own != nullptr)
+		{
+			own->leave();
+		}
+		all.leave();
+	};
+
+	//只有b在执行，可以借用a的保底名额
+	vector<future<void>> results;
+	for (int i = 0; i < tasks; i++)
+	{
+		results.push_back(b.submitTask(work, &onlyB));
+	}
+	for (auto& result : results)
+	{
+		result.get();
+	}
+	results.clear();
+	for (int i = 0; i < tasks; i++)
+	{
+		results.push_back(a.submitTask(work, nullptr));
+		results.push_back(b.submitTask(work, nullptr));
+		budgetPeak = max(budgetPeak, budget.getRunning());
+	}
+	for (auto& result : results)
+	{
+		result.get();
+	}
+	report("never above the limit", all.peak <= limit && budgetPeak <= limit,
+		"peak " + to_string(all.peak.load()) + "/" + to_string(limit) + " running tasks, budget reported " + to_string(budgetPeak));
+	report("idle guarantee can be borrowed", onlyB.peak == limit,
+		"pool without guarantee reached " + to_string(onlyB.peak.load()) + "/" + to_string(limit));
+}
+
+//另一个线程池占满预算时，有保底的线程池在借用方执行完当前这批任务后拿到保底名额
+void checkGuarantee(int limit)
+{
+	ThreadBudget budget(limit);
+	ThreadPool guaranteed;
+	ThreadPool borrower;
+	guaranteed.setThreadBudget(budget, limit - 1);
+	borrower.setThreadBudget(budget, 0);
+	guaranteed.start(limit);
+	borrower.start(limit * 2);
+
+	//借用方的每个线程都一直有10ms的任务：任务执行完再提交下一个，
+	//队列不长，一批只取一个任务，刚启动时也不会一次取走一大批把名额占很久
+	atomic<bool> isStopped{ false };
+	atomic<int> loops{ limit * 2 };
+	function<void()> loop = [&] {
+		if (isStopped || !borrower.trySubmit([&] {
+			this_thread::sleep_for(chrono::milliseconds(10));
+			loop();
+		}))
+		{
+			loops--;
+		}
+	};
+	for (int i = 0; i < limit * 2; i++)
+	{
+		loop();
+	}
+	//确认预算已经被借用方占满
+	int busyBefore = 0;
+	for (int i = 0; i < 50; i++)
+	{
+		busyBefore = max(busyBefore, budget.getRunning());
+		this_thread::sleep_for(chrono::milliseconds(1));
+	}
+
+	Concurrency own;
+	Clock::time_point begin = Clock::now();
+	vector<future<double>> results;
+	for (int i = 0; i < (limit - 1) * 4; i++)
+	{
+		results.push_back(guaranteed.submitTask([&own, begin] {
+			double ms = chrono::duration<double, milli>(Clock::now() - begin).count();
+			own.enter();
+			this_thread::sleep_for(chrono::milliseconds(20));
+			own.leave();
+			return ms;
+		}));
+	}
+	double firstMs = 1e300;
+	for (auto& result : results)
+	{
+		firstMs = min(firstMs, result.get());
+	}
+	isStopped = true;
+	while (loops > 0)
+	{
+		this_thread::sleep_for(chrono::milliseconds(1));
+	}
+	ostringstream detail;
+	detail << fixed << setprecision(1) << "borrower held " << busyBefore << "/" << limit << ", guaranteed pool ran " << own.peak << "/" << limit - 1
+		<< " at once, first task started after " << firstMs << "ms";
+	report("guarantee honoured under load", busyBefore == limit && own.peak >= limit - 1 && firstMs < 50, detail.str());
+}
+
+int main(int argc, char* argv[])
+{
+	int limit = 3;
+	int tasks = 200;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		string arg = argv[i];
+		if (arg == "-b") limit = max(atoi(argv[i + 1]), 2);
+		else if (arg == "-n") tasks = max(atoi(argv[i + 1]), 10);
+		else
+		{
+			cerr << "unknown option: " << arg << endl;
+			return 1;
+		}
+	}
+	cerr << "budget: " << limit << "  tasks: " << tasks << endl;
+
+	checkClamp(limit);
+	checkLimit(limit, tasks);
+	checkGuarantee(limit);
+
+	cerr << (failures == 0 ? "all checks passed" : to_string(failures) + " checks failed") << endl;
+	return failures == 0 ? 0 : 1;
+}
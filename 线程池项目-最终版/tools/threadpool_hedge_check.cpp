@@ -0,0 +1,212 @@
+﻿// threadpool_hedge_check.cpp : 检查对冲执行（submitHedged/setHedgeBudget）的行为
+//
+// 用法：threadpool_hedge_check [-t threads] [-n calls]
+//   -t           线程数，默认4，至少2
+//   -n           每项检查的调用次数，默认100
+// 线程池本身会往标准输出打印日志，报告输出到标准错误：threadpool_hedge_check > /dev/null
+// 全部检查通过时返回0
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <memory>
+#include <future>
+#include <stdexcept>
+#include <algorithm>
+#include <cstdlib>
+#include "../threadpool.h"
+using namespace std;
+
+using Clock = std::chrono::steady_clock;
+
+int failures = 0;
+
+void report(const string& name, bool ok, const string& detail)
+{
+	cerr << (ok ? "  ok    " : "  FAIL  ") << name << "  " << detail << endl;
+	if (!ok)
+	{
+		failures++;
+	}
+}
+
+//第一份执行忙等duration，另一份执行完成后提前返回
+void runFor(chrono::milliseconds duration)
+{
+	Clock::time_point end = Clock::now() + duration;
+	while (Clock::now() < end && !isTaskCancelRequested())
+	{
+		this_thread::sleep_for(chrono::microseconds(200));
+	}
+}
+
+//一次调用的两份执行共享这个计数，第0份是第一份执行
+struct Attempts
+{
+	atomic<int> started{ 0 };
+	atomic<bool> isPrimaryCancelled{ false };
+	atomic<bool> isPrimaryDone{ false };
+};
+
+//第一份很慢时，对冲的那份先完成，结果被采用，第一份得知可以提前结束
+void checkSlowPrimary(int threads, int calls)
+{
+	ThreadPool pool;
+	pool.start(threads);
+	pool.setHedgeBudget(100);
+	int hedgedWins = 0;
+	int cancelled = 0;
+	double maxMs = 0;
+	for (int i = 0; i < calls; i++)
+	{
+		auto attempts = make_shared<Attempts>();
+		Clock::time_point begin = Clock::now();
+		int value = pool.submitHedged(chrono::milliseconds(20), [attempts] {
+			int attempt = attempts->started++;
+			if (attempt == 0)
+			{
+				runFor(chrono::milliseconds(1000));
+				attempts->isPrimaryCancelled = isTaskCancelRequested();
+			}
+			return attempt;
+		}).get();
+		maxMs = max(maxMs, chrono::duration<double, milli>(Clock::now() - begin).count());
+		hedgedWins += value == 1;
+		//第一份看到取消标志后很快返回
+		Clock::time_point end = Clock::now() + chrono::milliseconds(100);
+		while (!attempts->isPrimaryCancelled && Clock::now() < end)
+		{
+			this_thread::sleep_for(chrono::milliseconds(1));
+		}
+		cancelled += attempts->isPrimaryCancelled;
+	}
+	ostringstream detail;
+	detail << fixed << setprecision(1) << hedgedWins << "/" << calls << " hedge results used, "
+		<< cancelled << " primaries cancelled, max latency " << maxMs << "ms";
+	report("slow primary is hedged", hedgedWins == calls && cancelled == calls && maxMs < 500, detail.str());
+}
+
+//对冲执行数不超过预算，预算为0时不再对冲
+void checkBudget(int threads, int calls)
+{
+	for (int percent : { 10, 0 })
+	{
+		ThreadPool pool;
+		pool.start(threads);
+		pool.setHedgeBudget(percent);
+		int hedges = 0;
+		for (int i = 0; i < calls; i++)
+		{
+			auto attempts = make_shared<Attempts>();
+			pool.submitHedged(chrono::milliseconds(1), [attempts] {
+				if (attempts->started++ == 0)
+				{
+					runFor(chrono::milliseconds(5));
+				}
+				return 0;
+			}).get();
+			//等没有被取消的第一份也结束，再统计这次调用一共执行了几份
+			this_thread::sleep_for(chrono::milliseconds(6));
+			hedges += attempts->started - 1;
+		}
+		int allowed = calls * percent / 100;
+		report("hedge budget " + to_string(percent) + "%", hedges <= allowed,
+			to_string(hedges) + " hedges for " + to_string(calls) + " calls, budget " + to_string(allowed));
+	}
+}
+
+//先完成的那份抛出的异常也会被采用
+void checkException(int threads)
+{
+	ThreadPool pool;
+	pool.start(threads);
+	future<int> result = pool.submitHedged(chrono::milliseconds(20), []()->int {
+		throw runtime_error("hedged failure");
+	});
+	bool isThrown = false;
+	try
+	{
+		result.get();
+	}
+	catch (const runtime_error&)
+	{
+		isThrown = true;
+	}
+	report("exception is the result", isThrown, isThrown ? "runtime_error rethrown" : "no exception");
+}
+
+//自适应延迟按第一份的完整执行时间统计：1/5的调用很慢、被对冲时，历史里记的仍然是慢的时间，
+//95分位数不低于after，执行20ms的少数调用不会被对冲；只记对冲那份的执行时间的话，分位数会降到1ms左右
+void checkHistory(int threads, int calls)
+{
+	ThreadPool pool;
+	pool.start(threads);
+	pool.setHedgeBudget(100);
+	int fastCalls = 0;
+	int fastHedges = 0;
+	int slowCalls = 0;
+	int slowHedges = 0;
+	for (int i = 0; i < calls * 3; i++)
+	{
+		bool isSlow = i % 5 == 0;
+		chrono::milliseconds duration(isSlow ? 500 : (i % 25 == 1 ? 20 : 1));
+		auto attempts = make_shared<Attempts>();
+		pool.submitHedged(chrono::milliseconds(50), [attempts, duration] {
+			if (attempts->started++ == 0)
+			{
+				runFor(duration);
+				attempts->isPrimaryDone = true;
+			}
+			return 0;
+		}).get();
+		//等第一份结束，把它的执行时间记进历史
+		Clock::time_point end = Clock::now() + chrono::milliseconds(100);
+		while (!attempts->isPrimaryDone && Clock::now() < end)
+		{
+			this_thread::sleep_for(chrono::milliseconds(1));
+		}
+		if (isSlow)
+		{
+			slowCalls++;
+			slowHedges += attempts->started - 1;
+		}
+		else
+		{
+			fastCalls++;
+			fastHedges += attempts->started - 1;
+		}
+	}
+	report("history keeps slow primaries", fastHedges == 0 && slowHedges == slowCalls,
+		to_string(fastHedges) + "/" + to_string(fastCalls) + " fast calls hedged, " + to_string(slowHedges) + "/" + to_string(slowCalls) + " slow calls hedged");
+}
+
+int main(int argc, char* argv[])
+{
+	int threads = 4;
+	int calls = 100;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		string arg = argv[i];
+		if (arg == "-t") threads = max(atoi(argv[i + 1]), 2);
+		else if (arg == "-n") calls = max(atoi(argv[i + 1]), 10);
+		else
+		{
+			cerr << "unknown option: " << arg << endl;
+			return 1;
+		}
+	}
+	cerr << "threads: " << threads << "  calls: " << calls << endl;
+
+	checkSlowPrimary(threads, calls);
+	checkBudget(threads, calls);
+	checkException(threads);
+	checkHistory(threads, calls);
+
+	cerr << (failures == 0 ? "all checks passed" : to_string(failures) + " checks failed") << endl;
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,216 @@
+﻿// threadpool_placement_check.cpp : 检查任务放置（submitTask(TaskPlacement, ...)）的执行位置和顺序
+//
+// 用法：threadpool_placement_check [-t threads] [-n tasks]
+//   -t           线程数，默认4，至少2
+//   -n           每项检查提交的任务数，默认200
+// 线程池本身会往标准输出打印日志，报告输出到标准错误：threadpool_placement_check > /dev/null
+// 全部检查通过时返回0
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <future>
+#include <algorithm>
+#include <cstdlib>
+#include "../threadpool.h"
+using namespace std;
+
+using Clock = std::chrono::steady_clock;
+
+int failures = 0;
+
+void report(const string& name, bool ok, const string& detail)
+{
+	cerr << (ok ? "  ok    " : "  FAIL  ") << name << "  " << detail << endl;
+	if (!ok)
+	{
+		failures++;
+	}
+}
+
+//记录任务的执行顺序
+struct OrderLog
+{
+	mutex mtx;
+	vector<int> order;
+
+	void add(int value)
+	{
+		lock_guard<mutex> lock(mtx);
+		order.push_back(value);
+	}
+};
+
+//逆序对的个数，0表示完全按提交顺序执行
+size_t inversions(const vector<int>& order)
+{
+	size_t count = 0;
+	for (size_t i = 0; i + 1 < order.size(); i++)
+	{
+		if (order[i] > order[i + 1])
+		{
+			count++;
+		}
+	}
+	return count;
+}
+
+//目标线程空闲时，放置给它的任务都在它上面执行
+void checkIdleWorker(int threads, int tasks)
+{
+	ThreadPool pool;
+	pool.start(threads);
+	this_thread::sleep_for(chrono::milliseconds(50));
+	int misplaced = 0;
+	for (int i = 0; i < tasks; i++)
+	{
+		int worker = i % threads;
+		int ran = pool.submitTask(TaskPlacement::onWorker(worker), [&pool] { return pool.getWorkerIndex(); }).get();
+		if (ran != worker)
+		{
+			misplaced++;
+		}
+	}
+	report("onWorker, idle target", misplaced == 0, to_string(misplaced) + " of " + to_string(tasks) + " tasks ran on another worker");
+}
+
+//目标线程正忙时放置给它的任务排队，之后按提交顺序执行；只有一个线程，不会被偷走
+void checkPlacedFifo(int tasks)
+{
+	ThreadPool pool;
+	pool.start(1);
+	promise<void> gate;
+	shared_future<void> opened = gate.get_future().share();
+	future<void> blocker = pool.submitTask(TaskPlacement::onWorker(0), [opened] { opened.wait(); });
+	this_thread::sleep_for(chrono::milliseconds(20));
+
+	OrderLog log;
+	vector<future<void>> results;
+	for (int i = 0; i < tasks; i++)
+	{
+		results.push_back(pool.submitTask(TaskPlacement::onWorker(0), [&log, i] { log.add(i); }));
+	}
+	gate.set_value();
+	for (auto& result : results)
+	{
+		result.get();
+	}
+	size_t count = inversions(log.order);
+	report("onWorker, FIFO while busy", count == 0 && log.order.size() == (size_t)tasks,
+		to_string(count) + " out-of-order pairs in " + to_string(log.order.size()) + " tasks");
+}
+
+//currentWorker()提交的后续任务在父任务结束后按后进先出执行
+void checkContinuationLifo(int tasks)
+{
+	ThreadPool pool;
+	pool.start(1);
+	OrderLog log;
+	vector<future<void>> results;
+	pool.submitTask([&] {
+		for (int i = 0; i < tasks; i++)
+		{
+			results.push_back(pool.submitTask(TaskPlacement::currentWorker(), [&log, i] { log.add(i); }));
+		}
+	}).get();
+	for (auto& result : results)
+	{
+		result.get();
+	}
+	vector<int> reversed = log.order;
+	reverse(reversed.begin(), reversed.end());
+	size_t count = inversions(reversed);
+	report("currentWorker, LIFO", count == 0 && log.order.size() == (size_t)tasks,
+		to_string(count) + " pairs not newest-first in " + to_string(log.order.size()) + " tasks");
+}
+
+//目标线程一直忙时，排队超过LOCAL_STEAL_DELAY_US的任务被空闲线程偷走执行
+void checkSteal(int threads, int tasks)
+{
+	ThreadPool pool;
+	pool.start(threads);
+	this_thread::sleep_for(chrono::milliseconds(50));
+	promise<void> gate;
+	shared_future<void> opened = gate.get_future().share();
+	future<void> blocker = pool.submitTask(TaskPlacement::onWorker(0), [opened] { opened.wait(); });
+	this_thread::sleep_for(chrono::milliseconds(20));
+
+	int early = 0;
+	int onTarget = 0;
+	double maxMs = 0;
+	for (int i = 0; i < tasks; i++)
+	{
+		Clock::time_point begin = Clock::now();
+		auto result = pool.submitTask(TaskPlacement::onWorker(0), [&pool, begin] {
+			return make_pair(pool.getWorkerIndex(), Clock::now() - begin);
+		}).get();
+		double ms = chrono::duration<double, milli>(result.second).count();
+		maxMs = max(maxMs, ms);
+		if (result.first == 0)
+		{
+			onTarget++;
+		}
+		if (result.second < chrono::microseconds(LOCAL_STEAL_DELAY_US))
+		{
+			early++;
+		}
+	}
+	gate.set_value();
+	blocker.get();
+	ostringstream detail;
+	detail << fixed << setprecision(2) << onTarget << " ran on the blocked worker, " << early
+		<< " stolen before " << LOCAL_STEAL_DELAY_US << "us, max latency " << maxMs << "ms";
+	report("onWorker, stolen from busy target", onTarget == 0 && early == 0 && maxMs < 100, detail.str());
+}
+
+//同一缓存域的任务都能执行完
+void checkSameGroup(int threads, int tasks)
+{
+	ThreadPool pool;
+	pool.start(threads);
+	atomic<int> done{ 0 };
+	vector<future<void>> results;
+	for (int i = 0; i < tasks; i++)
+	{
+		results.push_back(pool.submitTask(TaskPlacement::sameGroup(), [&done] { done++; }));
+	}
+	for (auto& result : results)
+	{
+		result.get();
+	}
+	report("sameGroup", done == tasks,
+		to_string(done.load()) + "/" + to_string(tasks) + " tasks, " + to_string(CpuTopology::instance().groupCount()) + " cache groups");
+}
+
+int main(int argc, char* argv[])
+{
+	int threads = 4;
+	int tasks = 200;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		string arg = argv[i];
+		if (arg == "-t") threads = max(atoi(argv[i + 1]), 2);
+		else if (arg == "-n") tasks = max(atoi(argv[i + 1]), 2);
+		else
+		{
+			cerr << "unknown option: " << arg << endl;
+			return 1;
+		}
+	}
+	cerr << "threads: " << threads << "  tasks: " << tasks << endl;
+
+	checkIdleWorker(threads, tasks);
+	checkPlacedFifo(tasks);
+	checkContinuationLifo(tasks);
+	checkSteal(threads, tasks);
+	checkSameGroup(threads, tasks);
+
+	cerr << (failures == 0 ? "all checks passed" : to_string(failures) + " checks failed") << endl;
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,241 @@
+﻿// threadpool_reactor_check.cpp : 用本地管道和socketpair检查线程池内置reactor（onReadable/onWritable）的行为
+//
+// 用法：threadpool_reactor_check [-t threads] [-n messages]
+//   -t           线程数，默认4
+//   -n           每项检查写入的消息数，默认2000
+// 线程池本身会往标准输出打印日志，报告输出到标准错误：threadpool_reactor_check > /dev/null
+// 全部检查通过时返回0
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <algorithm>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include "../threadpool.h"
+using namespace std;
+
+using Clock = std::chrono::steady_clock;
+
+int failures = 0;
+
+void report(const string& name, bool ok, const string& detail)
+{
+	cerr << (ok ? "  ok    " : "  FAIL  ") << name << "  " << detail << endl;
+	if (!ok)
+	{
+		failures++;
+	}
+}
+
+void setNonBlock(int fd)
+{
+	::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+//等待条件满足，最多等待timeout
+template<typename Pred>
+bool waitFor(Pred pred, chrono::milliseconds timeout = chrono::milliseconds(5000))
+{
+	Clock::time_point end = Clock::now() + timeout;
+	while (!pred())
+	{
+		if (Clock::now() > end)
+		{
+			return false;
+		}
+		this_thread::sleep_for(chrono::milliseconds(1));
+	}
+	return true;
+}
+
+//管道可读：边沿触发下回调读到EAGAIN，所有字节都要收到
+void checkPipe(ThreadPool& pool, int messages)
+{
+	int fds[2];
+	if (::pipe(fds) < 0)
+	{
+		report("pipe readable", false, "pipe fail");
+		return;
+	}
+	setNonBlock(fds[0]);
+	atomic<long> received{ 0 };
+	pool.onReadable(fds[0], [&](int fd) {
+		char buf[256];
+		ssize_t n;
+		while ((n = ::read(fd, buf, sizeof(buf))) > 0)
+		{
+			received += n;
+		}
+	});
+	for (int i = 0; i < messages; i++)
+	{
+		(void)::write(fds[1], "abcdefgh", 8);
+	}
+	long expected = (long)messages * 8;
+	bool ok = waitFor([&] { return received == expected; });
+	report("pipe readable", ok, to_string(received.load()) + "/" + to_string(expected) + " bytes");
+	pool.removeFd(fds[0]);
+	::close(fds[0]);
+	::close(fds[1]);
+}
+
+//socketpair两端互相回显：可写回调只触发一次，写完后需要重新注册
+void checkSocketPair(ThreadPool& pool, int messages)
+{
+	int sv[2];
+	if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0)
+	{
+		report("socketpair echo", false, "socketpair fail");
+		return;
+	}
+	setNonBlock(sv[0]);
+	setNonBlock(sv[1]);
+
+	//sv[1]收到什么就原样写回去
+	pool.onReadable(sv[1], [](int fd) {
+		char buf[256];
+		ssize_t n;
+		while ((n = ::read(fd, buf, sizeof(buf))) > 0)
+		{
+			(void)::write(fd, buf, n);
+		}
+	});
+	atomic<long> echoed{ 0 };
+	pool.onReadable(sv[0], [&](int fd) {
+		char buf[256];
+		ssize_t n;
+		while ((n = ::read(fd, buf, sizeof(buf))) > 0)
+		{
+			echoed += n;
+		}
+	});
+
+	atomic<int> writes{ 0 };
+	for (int i = 0; i < messages; i++)
+	{
+		int before = writes;
+		pool.onWritable(sv[0], [&](int fd) {
+			(void)::write(fd, "0123", 4);
+			writes++;
+		});
+		if (!waitFor([&] { return writes > before; }))
+		{
+			break;
+		}
+	}
+	long expected = (long)messages * 4;
+	bool ok = waitFor([&] { return echoed == expected; });
+	report("socketpair echo", ok && writes == messages,
+		to_string(writes.load()) + " writes, " + to_string(echoed.load()) + "/" + to_string(expected) + " bytes echoed");
+	pool.removeFd(sv[0]);
+	pool.removeFd(sv[1]);
+	::close(sv[0]);
+	::close(sv[1]);
+}
+
+//同一个fd的回调不能同时执行：回调排队或执行期间反复重新注册，也不能让事件提前挂上
+void checkOneShot(ThreadPool& pool, int messages)
+{
+	int sv[2];
+	if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0)
+	{
+		report("one callback per fd", false, "socketpair fail");
+		return;
+	}
+	setNonBlock(sv[0]);
+	atomic<int> running{ 0 };
+	atomic<int> overlaps{ 0 };
+	atomic<long> received{ 0 };
+	ThreadPool::IoCallback onRead = [&](int fd) {
+		if (running++ > 0)
+		{
+			overlaps++;
+		}
+		this_thread::sleep_for(chrono::microseconds(200));
+		char buf[256];
+		ssize_t n;
+		while ((n = ::read(fd, buf, sizeof(buf))) > 0)
+		{
+			received += n;
+		}
+		running--;
+	};
+	pool.onReadable(sv[0], onRead);
+
+	//一边写一边重新注册读写回调
+	for (int i = 0; i < messages; i++)
+	{
+		(void)::write(sv[1], "x", 1);
+		pool.onReadable(sv[0], onRead);
+		pool.onWritable(sv[0], [](int) {});
+	}
+	bool done = waitFor([&] { return received == messages; });
+	report("one callback per fd", done && overlaps == 0,
+		to_string(overlaps.load()) + " overlapping callbacks, " + to_string(received.load()) + "/" + to_string(messages) + " bytes");
+	pool.removeFd(sv[0]);
+	::close(sv[0]);
+	::close(sv[1]);
+}
+
+//removeFd之后不再调用回调
+void checkRemove(ThreadPool& pool)
+{
+	int fds[2];
+	if (::pipe(fds) < 0)
+	{
+		report("removeFd", false, "pipe fail");
+		return;
+	}
+	setNonBlock(fds[0]);
+	atomic<int> calls{ 0 };
+	pool.onReadable(fds[0], [&](int fd) {
+		char buf[64];
+		while (::read(fd, buf, sizeof(buf)) > 0)
+		{
+		}
+		calls++;
+	});
+	(void)::write(fds[1], "a", 1);
+	waitFor([&] { return calls > 0; });
+	pool.removeFd(fds[0]);
+	int before = calls;
+	(void)::write(fds[1], "b", 1);
+	this_thread::sleep_for(chrono::milliseconds(100));
+	report("removeFd", before == 1 && calls == before, to_string(calls.load()) + " calls");
+	::close(fds[0]);
+	::close(fds[1]);
+}
+
+int main(int argc, char* argv[])
+{
+	int threads = 4;
+	int messages = 2000;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		string arg = argv[i];
+		if (arg == "-t") threads = max(atoi(argv[i + 1]), 1);
+		else if (arg == "-n") messages = max(atoi(argv[i + 1]), 1);
+		else
+		{
+			cerr << "unknown option: " << arg << endl;
+			return 1;
+		}
+	}
+
+	ThreadPool pool;
+	pool.start(threads);
+	cerr << "threads: " << threads << "  messages: " << messages << endl;
+
+	checkPipe(pool, messages);
+	checkSocketPair(pool, messages);
+	checkOneShot(pool, messages);
+	checkRemove(pool);
+
+	cerr << (failures == 0 ? "all checks passed" : to_string(failures) + " checks failed") << endl;
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,233 @@
+﻿// threadpool_replay.cpp : 离线回放线程池任务轨迹，比较不同线程池配置下的吞吐和延迟
+//
+// 用法：threadpool_replay <trace> [-t threads] [-m fixed|cached] [-q locked|lockfree]
+//                          [-s speed] [--max-threads N] [--queue-size N] [--sleep]
+//   trace        ThreadPool::startRecording()生成的轨迹文件
+//   -t           初始线程数，默认和记录时的工作线程数一样
+//   -m           线程池模式，默认fixed
+//   -q           任务队列，默认locked（互斥锁队列）
+//   -s           回放速度倍数，2表示按两倍的提交速率回放，默认1
+//   --sleep      任务用sleep模拟执行时间（IO型任务），默认忙等（CPU型任务）
+// 线程池本身会往标准输出打印日志，报告输出到标准错误：threadpool_replay pool.trace > /dev/null
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include "../threadpool.h"
+using namespace std;
+
+using Clock = std::chrono::steady_clock;
+
+struct ReplayOptions
+{
+	int threads = 0;
+	PoolMode mode = PoolMode::MODE_FIXED;
+	bool isLockFree = false;
+	double speed = 1.0;
+	int maxThreads = THREAD_MAX_THRESHHOLD;
+	int queueSize = TASK_MAX_THRESHHOLD;
+	bool isSleep = false;
+};
+
+//回放时一个任务的结果
+struct ReplaySample
+{
+	int64_t waitNs = 0;    //提交到开始执行
+	int64_t latencyNs = 0; //提交到执行完
+	bool isRejected = false;
+};
+
+//按原来的提交时间间隔把任务提交给线程池，任务执行时间和记录的一样
+template<typename Pool>
+vector<ReplaySample> replay(const TraceData& trace, const ReplayOptions& opt, int64_t& totalNs)
+{
+	Pool pool;
+	pool.setMode(opt.mode);
+	pool.setTaskQueMaxThreshHold(opt.queueSize);
+	pool.setThreadSizeThreshHold(opt.maxThreads);
+	pool.start(opt.threads);
+
+	size_t n = trace.records.size();
+	vector<ReplaySample> samples(n);
+	mutex mtx;
+	condition_variable allDone;
+	size_t done = 0;
+	auto finish = [&]() {
+		lock_guard<mutex> lock(mtx);
+		if (++done == n)
+		{
+			allDone.notify_all();
+		}
+	};
+
+	auto begin = Clock::now();
+	uint64_t firstTick = n > 0 ? trace.records.front().submitTick : 0;
+	for (size_t i = 0; i < n; i++)
+	{
+		const TraceRecord& record = trace.records[i];
+		auto offset = chrono::nanoseconds((int64_t)((record.submitTick - firstTick) * trace.tickNs / opt.speed));
+		this_thread::sleep_until(begin + offset);
+
+		auto exec = chrono::nanoseconds((int64_t)record.execTick * trace.tickNs);
+		auto submitTime = Clock::now();
+		bool isSubmitted = pool.trySubmit([&samples, &finish, &opt, i, submitTime, exec]() {
+			auto start = Clock::now();
+			if (opt.isSleep)
+			{
+				this_thread::sleep_for(exec);
+			}
+			else
+			{
+				while (Clock::now() - start < exec)
+				{
+				}
+			}
+			samples[i].waitNs = chrono::duration_cast<chrono::nanoseconds>(start - submitTime).count();
+			samples[i].latencyNs = chrono::duration_cast<chrono::nanoseconds>(Clock::now() - submitTime).count();
+			finish();
+		});
+		if (!isSubmitted)
+		{
+			samples[i].isRejected = true;
+			finish();
+		}
+	}
+
+	unique_lock<mutex> lock(mtx);
+	allDone.wait(lock, [&]()->bool { return done == n; });
+	totalNs = chrono::duration_cast<chrono::nanoseconds>(Clock::now() - begin).count();
+	return samples;
+}
+
+//values会被排序
+string percentiles(vector<int64_t>& values)
+{
+	if (values.empty())
+	{
+		return "-";
+	}
+	sort(values.begin(), values.end());
+	auto at = [&](double p) {
+		size_t k = min(values.size() - 1, (size_t)(p * values.size()));
+		return values[k] / 1000.0;
+	};
+	ostringstream out;
+	out << fixed << setprecision(1)
+		<< "p50=" << at(0.5) << "us p90=" << at(0.9) << "us p99=" << at(0.99)
+		<< "us p99.9=" << at(0.999) << "us max=" << values.back() / 1000.0 << "us";
+	return out.str();
+}
+
+void report(const TraceData& trace, const vector<ReplaySample>& samples, int64_t totalNs)
+{
+	//按任务类分组，同时给出记录时的排队时间，方便对比
+	struct ClassStats
+	{
+		vector<int64_t> recordedWait, wait, latency;
+		size_t rejected = 0;
+	};
+	map<uint32_t, ClassStats> classes;
+	ClassStats all;
+	for (size_t i = 0; i < samples.size(); i++)
+	{
+		const TraceRecord& record = trace.records[i];
+		ClassStats& stats = classes[record.classId];
+		int64_t recordedWait = (int64_t)record.waitTick * trace.tickNs;
+		stats.recordedWait.push_back(recordedWait);
+		all.recordedWait.push_back(recordedWait);
+		if (samples[i].isRejected)
+		{
+			stats.rejected++;
+			all.rejected++;
+			continue;
+		}
+		stats.wait.push_back(samples[i].waitNs);
+		stats.latency.push_back(samples[i].latencyNs);
+		all.wait.push_back(samples[i].waitNs);
+		all.latency.push_back(samples[i].latencyNs);
+	}
+
+	cerr << "tasks: " << samples.size() << "  rejected: " << all.rejected
+		<< "  time: " << totalNs / 1e6 << "ms"
+		<< "  throughput: " << (totalNs > 0 ? all.wait.size() * 1e9 / totalNs : 0) << " tasks/s" << endl;
+	cerr << "recorded wait: " << percentiles(all.recordedWait) << endl;
+	cerr << "replay wait:   " << percentiles(all.wait) << endl;
+	cerr << "replay latency:" << percentiles(all.latency) << endl;
+	for (auto& entry : classes)
+	{
+		auto name = trace.classNames.find(entry.first);
+		cerr << endl << "class " << (name != trace.classNames.end() ? name->second : to_string(entry.first))
+			<< "  tasks: " << entry.second.recordedWait.size() << "  rejected: " << entry.second.rejected << endl;
+		cerr << "  recorded wait: " << percentiles(entry.second.recordedWait) << endl;
+		cerr << "  replay wait:   " << percentiles(entry.second.wait) << endl;
+		cerr << "  replay latency:" << percentiles(entry.second.latency) << endl;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		cerr << "usage: threadpool_replay <trace> [-t threads] [-m fixed|cached] [-q locked|lockfree]"
+			" [-s speed] [--max-threads N] [--queue-size N] [--sleep]" << endl;
+		return 1;
+	}
+
+	ReplayOptions opt;
+	for (int i = 2; i < argc; i++)
+	{
+		string arg = argv[i];
+		string value = i + 1 < argc ? argv[i + 1] : "";
+		if (arg == "--sleep")
+		{
+			opt.isSleep = true;
+			continue;
+		}
+		i++;
+		if (arg == "-t") opt.threads = atoi(value.c_str());
+		else if (arg == "-m") opt.mode = (value == "cached") ? PoolMode::MODE_CACHED : PoolMode::MODE_FIXED;
+		else if (arg == "-q") opt.isLockFree = (value == "lockfree");
+		else if (arg == "-s") opt.speed = max(atof(value.c_str()), 0.001);
+		else if (arg == "--max-threads") opt.maxThreads = atoi(value.c_str());
+		else if (arg == "--queue-size") opt.queueSize = atoi(value.c_str());
+		else
+		{
+			cerr << "unknown option: " << arg << endl;
+			return 1;
+		}
+	}
+
+	TraceData trace;
+	if (!readTrace(argv[1], trace))
+	{
+		return 1;
+	}
+	if (opt.threads <= 0)
+	{
+		//默认用记录时的工作线程数
+		set<uint32_t> workers;
+		for (const TraceRecord& record : trace.records)
+		{
+			workers.insert(record.worker);
+		}
+		opt.threads = max((int)workers.size(), 1);
+	}
+
+	int64_t totalNs = 0;
+	vector<ReplaySample> samples = opt.isLockFree
+		? replay<BasicThreadPool<LockFreeQueue>>(trace, opt, totalNs)
+		: replay<ThreadPool>(trace, opt, totalNs);
+
+	cerr << "threads: " << opt.threads << "  mode: " << (opt.mode == PoolMode::MODE_CACHED ? "cached" : "fixed")
+		<< "  queue: " << (opt.isLockFree ? "lockfree" : "locked") << "  speed: " << opt.speed << endl;
+	report(trace, samples, totalNs);
+	return 0;
+}
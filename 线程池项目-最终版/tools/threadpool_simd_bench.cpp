@@ -0,0 +1,158 @@
+﻿// threadpool_simd_bench.cpp : 比较并行归约在各个SIMD级别、各种元素类型下的耗时
+//
+// 用法：threadpool_simd_bench [-n elements] [-t threads] [-r rounds]
+//   -n           数组元素个数，默认16M
+//   -t           线程数，默认CPU核数
+//   -r           每项测试重复次数，取最快的一次，默认5
+// 线程池本身会往标准输出打印日志，报告输出到标准错误：threadpool_simd_bench > /dev/null
+// 各个SIMD级别的结果要和标量代码一致（浮点求和、点积只是累加顺序不同，允许很小的相对误差），不一致时返回1
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+#include <random>
+#include "../threadpool.h"
+#include "../threadpool_simd.h"
+using namespace std;
+
+using Clock = std::chrono::steady_clock;
+
+const char* SIMD_LEVEL_NAMES[] = { "scalar", "sse2", "avx2", "avx512" };
+const double SUM_REL_TOLERANCE = 1e-9; //浮点求和、点积结果允许的相对误差
+
+int failures = 0;
+
+//一个SIMD级别下各项归约的结果
+struct LevelResult
+{
+	double sum = 0;
+	double minValue = 0;
+	double maxValue = 0;
+	double dot = 0;
+	vector<uint64_t> hist;
+};
+
+bool isClose(double a, double b)
+{
+	return a == b || fabs(a - b) <= SUM_REL_TOLERANCE * max(fabs(a), fabs(b));
+}
+
+//和标量级别的结果比较，打印不一致的项
+void checkResult(const string& name, int level, const LevelResult& expected, const LevelResult& actual)
+{
+	string bad;
+	if (!isClose(expected.sum, actual.sum)) bad += " sum";
+	if (expected.minValue != actual.minValue || expected.maxValue != actual.maxValue) bad += " minmax";
+	if (!isClose(expected.dot, actual.dot)) bad += " dot";
+	if (expected.hist != actual.hist) bad += " hist";
+	if (!bad.empty())
+	{
+		cerr << "  MISMATCH " << name << " " << SIMD_LEVEL_NAMES[level] << ":" << bad << endl;
+		failures++;
+	}
+}
+
+//重复执行fn，返回最快一次的耗时（毫秒）
+template<typename Fn>
+double bestOf(int rounds, Fn fn)
+{
+	double best = 1e300;
+	for (int i = 0; i < rounds; i++)
+	{
+		Clock::time_point begin = Clock::now();
+		fn();
+		best = min(best, chrono::duration<double, milli>(Clock::now() - begin).count());
+	}
+	return best;
+}
+
+//一种元素类型在每个SIMD级别下的耗时，同时打印单线程标量代码的耗时作为基准
+template<typename T>
+void benchType(ThreadPool& pool, const string& name, size_t n, int rounds)
+{
+	//a是[0, 1000)内的随机数，浮点类型带小数，直方图的桶边界附近也有元素
+	vector<T> a(n);
+	vector<T> b(n);
+	mt19937 rng(12345);
+	for (size_t i = 0; i < n; i++)
+	{
+		a[i] = (T)(rng() % 1000000 / 1000.0);
+		b[i] = (T)(i % 7);
+	}
+	volatile double sink = 0; //防止结果没用到被优化掉
+
+	double mb = n * sizeof(T) / 1e6;
+	cerr << name << "  (" << mb << " MB)" << endl;
+	cerr << "  " << setw(8) << "level" << setw(12) << "sum ms" << setw(12) << "minmax ms"
+		<< setw(12) << "dot ms" << setw(12) << "hist ms" << setw(12) << "sum GB/s" << endl;
+
+	double scalarMs = bestOf(rounds, [&] { sink = sink + (double)simdSumScalar(a.data(), n); });
+	cerr << "  " << setw(8) << "1thread" << setw(12) << scalarMs << endl;
+
+	SimdLevel detected = detectSimdLevel();
+	LevelResult scalarResult;
+	for (int level = 0; level <= (int)detected; level++)
+	{
+		setMaxSimdLevel((SimdLevel)level);
+		LevelResult result;
+		result.sum = (double)parallelSum(pool, a.data(), n);
+		auto minMax = parallelMinMax(pool, a.data(), n);
+		result.minValue = (double)minMax.first;
+		result.maxValue = (double)minMax.second;
+		result.dot = (double)parallelDot(pool, a.data(), b.data(), n);
+		result.hist = parallelHistogram(pool, a.data(), n, (T)0, (T)1000, 97);
+		if (level == 0)
+		{
+			scalarResult = result;
+		}
+		else
+		{
+			checkResult(name, level, scalarResult, result);
+		}
+
+		double sumMs = bestOf(rounds, [&] { sink = sink + (double)parallelSum(pool, a.data(), n); });
+		double minMaxMs = bestOf(rounds, [&] { sink = sink + (double)parallelMinMax(pool, a.data(), n).second; });
+		double dotMs = bestOf(rounds, [&] { sink = sink + (double)parallelDot(pool, a.data(), b.data(), n); });
+		double histMs = bestOf(rounds, [&] { sink = sink + (double)parallelHistogram(pool, a.data(), n, (T)0, (T)1000, 64)[0]; });
+		cerr << "  " << setw(8) << SIMD_LEVEL_NAMES[level] << setw(12) << sumMs << setw(12) << minMaxMs
+			<< setw(12) << dotMs << setw(12) << histMs << setw(12) << mb / sumMs << endl;
+	}
+	setMaxSimdLevel(SimdLevel::SIMD_AVX512);
+}
+
+int main(int argc, char* argv[])
+{
+	size_t n = 16 << 20;
+	int threads = (int)thread::hardware_concurrency();
+	int rounds = 5;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		string arg = argv[i];
+		if (arg == "-n") n = (size_t)atoll(argv[i + 1]);
+		else if (arg == "-t") threads = atoi(argv[i + 1]);
+		else if (arg == "-r") rounds = max(atoi(argv[i + 1]), 1);
+		else
+		{
+			cerr << "unknown option: " << arg << endl;
+			return 1;
+		}
+	}
+
+	ThreadPool pool;
+	pool.start(max(threads, 1));
+	cerr << fixed << setprecision(2);
+	cerr << "threads: " << threads << "  elements: " << n << "  detected: " << SIMD_LEVEL_NAMES[(int)detectSimdLevel()] << endl;
+
+	benchType<int32_t>(pool, "int32", n, rounds);
+	benchType<int64_t>(pool, "int64", n, rounds);
+	benchType<float>(pool, "float", n, rounds);
+	benchType<double>(pool, "double", n, rounds);
+	cerr << (failures == 0 ? "all levels match scalar" : to_string(failures) + " mismatches") << endl;
+	return failures == 0 ? 0 : 1;
+}
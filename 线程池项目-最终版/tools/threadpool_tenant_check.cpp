@@ -0,0 +1,257 @@
+﻿// threadpool_tenant_check.cpp : 检查租户调度（setTenant/submitTask(TenantId, ...)）的行为
+//
+// 用法：threadpool_tenant_check [-t threads] [-n tasks]
+//   -t           线程数，默认4
+//   -n           每项检查提交的任务数，默认2000
+// 线程池本身会往标准输出打印日志，报告输出到标准错误：threadpool_tenant_check > /dev/null
+// 全部检查通过时返回0
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <future>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+#include "../threadpool.h"
+using namespace std;
+
+using Clock = std::chrono::steady_clock;
+
+int failures = 0;
+
+void report(const string& name, bool ok, const string& detail)
+{
+	cerr << (ok ? "  ok    " : "  FAIL  ") << name << "  " << detail << endl;
+	if (!ok)
+	{
+		failures++;
+	}
+}
+
+//让所有工作线程阻塞在gate上，返回后提交的任务都只能排队
+vector<future<void>> blockWorkers(ThreadPool& pool, int threads, shared_future<void> gate)
+{
+	vector<future<void>> blockers;
+	for (int i = 0; i < threads; i++)
+	{
+		blockers.push_back(pool.submitTask([gate] { gate.wait(); }));
+	}
+	this_thread::sleep_for(chrono::milliseconds(50));
+	return blockers;
+}
+
+//记录任务的执行顺序
+struct OrderLog
+{
+	mutex mtx;
+	vector<int> order;
+
+	void add(int tenant)
+	{
+		lock_guard<mutex> lock(mtx);
+		order.push_back(tenant);
+	}
+};
+
+//单线程时执行顺序就是出队顺序，权重3:1的两个租户应该严格按1,1,1,2轮流
+void checkDrrOrder(int tasks)
+{
+	ThreadPool pool;
+	pool.start(1);
+	pool.setTenant(1, 3);
+	pool.setTenant(2, 1);
+	promise<void> gate;
+	auto blockers = blockWorkers(pool, 1, gate.get_future().share());
+
+	OrderLog log;
+	vector<future<void>> results;
+	for (int i = 0; i < tasks; i++)
+	{
+		results.push_back(pool.submitTask(1, [&log] { log.add(1); }));
+		if (i % 3 == 0)
+		{
+			results.push_back(pool.submitTask(2, [&log] { log.add(2); }));
+		}
+	}
+	gate.set_value();
+	for (auto& result : results)
+	{
+		result.get();
+	}
+
+	//两个租户都还有任务时，每4个任务里租户1占3个
+	size_t both = min<size_t>(log.order.size(), (size_t)(tasks / 3) * 4);
+	size_t mismatch = 0;
+	for (size_t i = 0; i < both; i++)
+	{
+		if (log.order[i] != (i % 4 == 3 ? 2 : 1))
+		{
+			mismatch++;
+		}
+	}
+	report("drr order (1 thread)", mismatch == 0, to_string(mismatch) + " of " + to_string(both) + " positions out of 1,1,1,2 order");
+}
+
+//多线程时工作线程一次批量取走一段出队顺序，执行顺序会偏离DRR；
+//按窗口统计租户1的占比（期望0.75），任务很短（批量取）和任务较长（一次取一个）两种情况都不能偏离太多
+void checkDrrShare(int threads, int tasks, bool isShort)
+{
+	ThreadPool pool;
+	pool.start(threads);
+	pool.setTenant(1, 3);
+	pool.setTenant(2, 1);
+	promise<void> gate;
+	auto blockers = blockWorkers(pool, threads, gate.get_future().share());
+
+	OrderLog log;
+	auto work = chrono::microseconds(isShort ? 1 : 200);
+	auto spin = [work] {
+		auto end = Clock::now() + work;
+		while (Clock::now() < end)
+		{
+		}
+	};
+	vector<future<void>> results;
+	for (int i = 0; i < tasks; i++)
+	{
+		results.push_back(pool.submitTask(1, [&log, spin] { spin(); log.add(1); }));
+		results.push_back(pool.submitTask(2, [&log, spin] { spin(); log.add(2); }));
+	}
+	gate.set_value();
+	for (auto& result : results)
+	{
+		result.get();
+	}
+
+	//租户2在前4/3*tasks个任务里还没取完，只统计这一段；窗口取一批的大小，批量取造成的偏差最明显
+	size_t window = TASK_BATCH_MAX_SIZE;
+	size_t both = (size_t)tasks * 4 / 3;
+	double worst = 0;
+	for (size_t begin = 0; begin + window <= both; begin += window)
+	{
+		size_t ones = count(log.order.begin() + begin, log.order.begin() + begin + window, 1);
+		worst = max(worst, abs((double)ones / window - 0.75));
+	}
+	ostringstream detail;
+	detail << fixed << setprecision(3) << "worst share deviation " << worst << " per " << window << " tasks";
+	report(isShort ? "drr share, batched short tasks" : "drr share, long tasks", worst <= 0.2, detail.str());
+}
+
+//设置了maxInFlight的租户同时执行的任务数不超过上限，而且不影响其他租户
+void checkMaxInFlight(int threads, int tasks)
+{
+	ThreadPool pool;
+	pool.start(threads);
+	pool.setTenant(1, 1, 2);
+	atomic<int> running{ 0 };
+	atomic<int> peak{ 0 };
+	atomic<int> others{ 0 };
+	vector<future<void>> results;
+	for (int i = 0; i < tasks; i++)
+	{
+		results.push_back(pool.submitTask(1, [&] {
+			int now = ++running;
+			int old = peak;
+			while (now > old && !peak.compare_exchange_weak(old, now))
+			{
+			}
+			this_thread::sleep_for(chrono::microseconds(50));
+			running--;
+		}));
+		results.push_back(pool.submitTask(2, [&] { others++; }));
+	}
+	for (auto& result : results)
+	{
+		result.get();
+	}
+	report("maxInFlight", peak <= 2 && others == tasks,
+		"peak " + to_string(peak.load()) + "/2 running, " + to_string(others.load()) + "/" + to_string(tasks) + " other tenant tasks");
+}
+
+//maxQueued满的租户提交被拒绝，其他租户照常提交
+void checkMaxQueued(int threads)
+{
+	ThreadPool pool;
+	pool.start(threads);
+	pool.setTenant(1, 1, 0, 5);
+	promise<void> gate;
+	auto blockers = blockWorkers(pool, threads, gate.get_future().share());
+
+	vector<future<int>> results;
+	for (int i = 0; i < 7; i++)
+	{
+		results.push_back(pool.submitTask(1, [] { return 1; }));
+	}
+	Clock::time_point begin = Clock::now();
+	future<int> other = pool.submitTask(2, [] { return 1; });
+	double otherMs = chrono::duration<double, milli>(Clock::now() - begin).count();
+	size_t queued = pool.getTenantStats(1).queueSize;
+	gate.set_value();
+
+	int accepted = 0;
+	for (auto& result : results)
+	{
+		accepted += result.get();
+	}
+	bool ok = accepted == 5 && queued == 5 && other.get() == 1 && otherMs < 100;
+	ostringstream detail;
+	detail << fixed << setprecision(1) << accepted << "/7 accepted, " << queued << " queued, other tenant submitted in " << otherMs << "ms";
+	report("maxQueued", ok, detail.str());
+}
+
+//没有用过的租户返回全0的统计，用过的租户统计出队数
+void checkStats(int tasks)
+{
+	ThreadPool pool;
+	pool.start(2);
+	ThreadPool::TenantStats unknown = pool.getTenantStats(12345);
+	bool isZero = unknown.queueSize == 0 && unknown.inFlight == 0 && unknown.dequeued == 0
+		&& unknown.avgWaitMs == 0 && unknown.maxWaitMs == 0;
+	vector<future<void>> results;
+	for (int i = 0; i < tasks; i++)
+	{
+		results.push_back(pool.submitTask(7, [] {}));
+	}
+	for (auto& result : results)
+	{
+		result.get();
+	}
+	ThreadPool::TenantStats stats = pool.getTenantStats(7);
+	report("tenant stats", isZero && stats.dequeued == (uint64_t)tasks && stats.queueSize == 0,
+		"unknown tenant " + string(isZero ? "zero" : "not zero") + ", dequeued " + to_string(stats.dequeued) + "/" + to_string(tasks));
+}
+
+int main(int argc, char* argv[])
+{
+	int threads = 4;
+	int tasks = 2000;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		string arg = argv[i];
+		if (arg == "-t") threads = max(atoi(argv[i + 1]), 1);
+		else if (arg == "-n") tasks = max(atoi(argv[i + 1]), 3);
+		else
+		{
+			cerr << "unknown option: " << arg << endl;
+			return 1;
+		}
+	}
+	cerr << "threads: " << threads << "  tasks: " << tasks << endl;
+
+	checkDrrOrder(tasks);
+	checkDrrShare(threads, tasks, true);
+	checkDrrShare(threads, tasks, false);
+	checkMaxInFlight(threads, tasks);
+	checkMaxQueued(threads);
+	checkStats(tasks);
+
+	cerr << (failures == 0 ? "all checks passed" : to_string(failures) + " checks failed") << endl;
+	return failures == 0 ? 0 : 1;
+}
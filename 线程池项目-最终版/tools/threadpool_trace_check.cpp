@@ -0,0 +1,198 @@
+﻿// threadpool_trace_check.cpp : 检查任务轨迹记录（startRecording/stopRecording）写出的文件
+//
+// 用法：threadpool_trace_check [-t threads] [-n tasks] [-o dir]
+//   -t           线程数，默认4
+//   -n           每项检查提交的任务数，默认5000，超过TRACE_BUFFER_SIZE才能覆盖缓冲区写满的情况
+//   -o           轨迹文件存放的目录，默认当前目录，检查完删除
+// 线程池本身会往标准输出打印日志，报告输出到标准错误：threadpool_trace_check > /dev/null
+// 全部检查通过时返回0
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <future>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include "../threadpool.h"
+using namespace std;
+
+int failures = 0;
+
+void report(const string& name, bool ok, const string& detail)
+{
+	cerr << (ok ? "  ok    " : "  FAIL  ") << name << "  " << detail << endl;
+	if (!ok)
+	{
+		failures++;
+	}
+}
+
+long fileSize(const string& path)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (file == nullptr)
+	{
+		return -1;
+	}
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fclose(file);
+	return size;
+}
+
+//每个任务一条记录，两种lambda是两个任务类，执行时间和排队时间和实际相符
+void checkRecords(const string& dir, int threads, int tasks)
+{
+	string path = dir + "/trace_check_records.trace";
+	ThreadPool pool;
+	pool.start(threads);
+	if (!pool.startRecording(path))
+	{
+		report("records", false, "startRecording fail");
+		return;
+	}
+
+	//先堵住所有工作线程，后面提交的任务至少排队50ms
+	promise<void> gate;
+	shared_future<void> opened = gate.get_future().share();
+	vector<future<void>> results;
+	for (int i = 0; i < threads; i++)
+	{
+		results.push_back(pool.submitTask([opened] { opened.wait(); }));
+	}
+	this_thread::sleep_for(chrono::milliseconds(10));
+	for (int i = 0; i < tasks; i++)
+	{
+		results.push_back(pool.submitTask([] {}));
+	}
+	results.push_back(pool.submitTask([] { this_thread::sleep_for(chrono::milliseconds(5)); }));
+	this_thread::sleep_for(chrono::milliseconds(50));
+	gate.set_value();
+	for (auto& result : results)
+	{
+		result.get();
+	}
+	pool.stopRecording();
+
+	TraceData trace;
+	if (!readTrace(path, trace))
+	{
+		report("records", false, "readTrace fail");
+		return;
+	}
+	size_t expected = (size_t)threads + tasks + 1;
+	report("records", trace.records.size() == expected && trace.classNames.size() == 3,
+		to_string(trace.records.size()) + "/" + to_string(expected) + " records, " + to_string(trace.classNames.size()) + "/3 task classes");
+
+	//最后一个任务（按提交时间排序）执行了5ms，排在它前面的普通任务都排队了50ms以上
+	uint64_t tickMs = 1000000 / trace.tickNs;
+	size_t shortWaits = 0;
+	for (size_t i = threads; i < trace.records.size(); i++)
+	{
+		if (trace.records[i].waitTick < 50 * tickMs)
+		{
+			shortWaits++;
+		}
+	}
+	bool isSlowOk = !trace.records.empty() && trace.records.back().execTick >= 5 * tickMs;
+	report("wait and exec time", shortWaits == 0 && isSlowOk,
+		to_string(shortWaits) + " queued tasks waited < 50ms, sleeping task exec " + (isSlowOk ? ">= 5ms" : "< 5ms"));
+	remove(path.c_str());
+}
+
+//开始记录之前提交的任务不记录，结束记录之后文件不再变化
+void checkWindow(const string& dir, int threads, int tasks)
+{
+	string path = dir + "/trace_check_window.trace";
+	ThreadPool pool;
+	pool.start(threads);
+
+	promise<void> gate;
+	shared_future<void> opened = gate.get_future().share();
+	vector<future<void>> results;
+	for (int i = 0; i < tasks; i++)
+	{
+		results.push_back(pool.submitTask([opened] { opened.wait(); }));
+	}
+	pool.startRecording(path);
+	gate.set_value();
+	for (int i = 0; i < tasks; i++)
+	{
+		results.push_back(pool.submitTask([] {}));
+	}
+	for (auto& result : results)
+	{
+		result.get();
+	}
+	pool.stopRecording();
+	long size = fileSize(path);
+	for (int i = 0; i < tasks; i++)
+	{
+		pool.submitTask([] {}).get();
+	}
+
+	TraceData trace;
+	bool isRead = readTrace(path, trace);
+	report("recording window", isRead && trace.records.size() == (size_t)tasks && fileSize(path) == size,
+		to_string(trace.records.size()) + "/" + to_string(tasks) + " records, file " + (fileSize(path) == size ? "unchanged" : "changed") + " after stop");
+	remove(path.c_str());
+}
+
+//重新startRecording时上一个文件写完关闭，打不开的路径返回false
+void checkRestart(const string& dir, int threads, int tasks)
+{
+	string first = dir + "/trace_check_first.trace";
+	string second = dir + "/trace_check_second.trace";
+	ThreadPool pool;
+	pool.start(threads);
+	pool.startRecording(first);
+	for (int i = 0; i < tasks; i++)
+	{
+		pool.submitTask([] {}).get();
+	}
+	pool.startRecording(second);
+	for (int i = 0; i < tasks / 2; i++)
+	{
+		pool.submitTask([] {}).get();
+	}
+	bool isBadPathRejected = !pool.startRecording(dir + "/no_such_dir/x.trace");
+	pool.stopRecording();
+
+	TraceData a;
+	TraceData b;
+	bool isRead = readTrace(first, a) && readTrace(second, b);
+	report("restart recording", isRead && a.records.size() == (size_t)tasks && b.records.size() == (size_t)(tasks / 2) && isBadPathRejected,
+		to_string(a.records.size()) + " + " + to_string(b.records.size()) + " records, bad path " + (isBadPathRejected ? "rejected" : "accepted"));
+	remove(first.c_str());
+	remove(second.c_str());
+}
+
+int main(int argc, char* argv[])
+{
+	int threads = 4;
+	int tasks = 5000;
+	string dir = ".";
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		string arg = argv[i];
+		if (arg == "-t") threads = max(atoi(argv[i + 1]), 1);
+		else if (arg == "-n") tasks = max(atoi(argv[i + 1]), 2);
+		else if (arg == "-o") dir = argv[i + 1];
+		else
+		{
+			cerr << "unknown option: " << arg << endl;
+			return 1;
+		}
+	}
+	cerr << "threads: " << threads << "  tasks: " << tasks << endl;
+
+	checkRecords(dir, threads, tasks);
+	checkWindow(dir, threads, tasks);
+	checkRestart(dir, threads, tasks);
+
+	cerr << (failures == 0 ? "all checks passed" : to_string(failures) + " checks failed") << endl;
+	return failures == 0 ? 0 : 1;
+}